@@ -0,0 +1,202 @@
+#include <print>
+#include <new>
+#include <cstdlib>
+#include <cassert>
+#include <atomic>
+
+#include "allocation.h"
+
+// plain thread locals, zero initialized so touching them from operator new never runs an initializer
+thread_local Alloc_Stats t_alloc_stats{};
+thread_local bool        t_reporting = false;
+
+// constant initialized, so allocations made before main are counted too. the forbid depth is shared so a frame that
+// forbids allocating covers the thread pool's work for it as well
+constinit std::atomic<u64> g_alloc_count{0u};
+constinit std::atomic<u64> g_alloc_bytes{0u};
+constinit std::atomic<u32> g_forbid_depth{0u};
+
+static void on_alloc(size_t size)
+{
+    ++t_alloc_stats.m_count;
+    t_alloc_stats.m_bytes += size;
+
+    g_alloc_count.fetch_add(1u, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    // printing can allocate too, don't report those
+    if (g_forbid_depth.load(std::memory_order_relaxed) == 0u || t_reporting)
+        return;
+
+    t_reporting = true;
+    std::print("allocated {} bytes during an allocation-free frame\n", size);
+    t_reporting = false;
+
+    assert(!"allocation during an allocation-free frame");
+}
+
+static void* alloc(size_t size)
+{
+    on_alloc(size);
+    return std::malloc(size != 0u ? size : 1u);
+}
+
+static void* alloc_aligned(size_t size, std::align_val_t alignment)
+{
+    on_alloc(size);
+
+#if defined(_MSC_VER)
+    return _aligned_malloc(size != 0u ? size : 1u, (size_t)alignment);
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment
+    const size_t align = (size_t)alignment;
+    return std::aligned_alloc(align, (size + align - 1u) / align * align);
+#endif
+}
+
+static void free_aligned(void* ptr)
+{
+#if defined(_MSC_VER)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+Alloc_Stats thread_alloc_stats()
+{
+    return t_alloc_stats;
+}
+
+Alloc_Stats process_alloc_stats()
+{
+    return {g_alloc_count.load(std::memory_order_relaxed), g_alloc_bytes.load(std::memory_order_relaxed)};
+}
+
+Alloc_Forbid_Scope::Alloc_Forbid_Scope()
+{
+    g_forbid_depth.fetch_add(1u, std::memory_order_relaxed);
+}
+
+Alloc_Forbid_Scope::~Alloc_Forbid_Scope()
+{
+    g_forbid_depth.fetch_sub(1u, std::memory_order_relaxed);
+}
+
+void* imgui_alloc(size_t size, void* user_data)
+{
+    return ::operator new(size);
+}
+
+void imgui_free(void* ptr, void* user_data)
+{
+    ::operator delete(ptr);
+}
+
+// replacements for the global allocation functions, every new/delete in the program goes through these
+
+void* operator new(size_t size)
+{
+    if (void* ptr = alloc(size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return alloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return alloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (void* ptr = alloc_aligned(size, alignment))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return alloc_aligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return alloc_aligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    free_aligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    free_aligned(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+    free_aligned(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept
+{
+    free_aligned(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    free_aligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    free_aligned(ptr);
+}
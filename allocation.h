@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <memory_resource>
+
+#include "types.h"
+
+// every operator new (and ImGui, which is routed through it) is counted per thread and for the whole process
+struct Alloc_Stats
+{
+    u64 m_count;
+    u64 m_bytes;
+};
+
+// allocations made on the calling thread since it started, subtract two of these to get what happened in between
+Alloc_Stats thread_alloc_stats();
+
+// same but on every thread, including g_thread_pool's workers
+Alloc_Stats process_alloc_stats();
+
+// while one of these is alive every allocation on any thread is reported, and asserts in debug builds
+class Alloc_Forbid_Scope
+{
+public:
+    Alloc_Forbid_Scope();
+    ~Alloc_Forbid_Scope();
+
+    Alloc_Forbid_Scope(const Alloc_Forbid_Scope&)            = delete;
+    Alloc_Forbid_Scope& operator=(const Alloc_Forbid_Scope&) = delete;
+};
+
+// for ImGui::SetAllocatorFunctions
+void* imgui_alloc(size_t size, void* user_data);
+void  imgui_free(void* ptr, void* user_data);
+
+// bump allocator for data that only lives until the end of the frame, reset() hands the whole block back at once
+// running out spills to the general heap, which shows up in the allocation counts
+class Frame_Arena
+{
+    std::vector<std::byte>              m_buffer;
+    std::pmr::monotonic_buffer_resource m_resource;
+
+public:
+    Frame_Arena(size_t capacity) : m_buffer(capacity), m_resource(m_buffer.data(), m_buffer.size(), std::pmr::new_delete_resource()) {}
+
+    std::pmr::memory_resource* resource() { return &m_resource; }
+
+    void reset() { m_resource.release(); }
+};
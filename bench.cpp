@@ -0,0 +1,248 @@
+#include <print>
+#include <array>
+#include <format>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+#include <ctime>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "bench.h"
+#include "json.h"
+
+double median_of(std::vector<double> values)
+{
+    const size_t middle = values.size() / 2u;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+
+    return values[middle];
+}
+
+double Bench_Result::min() const
+{
+    return *std::min_element(m_samples.begin(), m_samples.end());
+}
+
+double Bench_Result::median() const
+{
+    return median_of(m_samples);
+}
+
+double Bench_Result::mean() const
+{
+    return std::accumulate(m_samples.begin(), m_samples.end(), 0.0) / m_samples.size();
+}
+
+double Bench_Result::stddev() const
+{
+    const double average = mean();
+
+    double total = 0.0;
+    for (double sample : m_samples)
+        total += (sample - average) * (sample - average);
+
+    return std::sqrt(total / std::max<size_t>(m_samples.size() - 1u, 1u));
+}
+
+double Bench_Result::mad_percent() const
+{
+    const double middle = median();
+
+    std::vector<double> deviations{};
+    deviations.reserve(m_samples.size());
+
+    for (double sample : m_samples)
+        deviations.push_back(std::abs(sample - middle));
+
+    return median_of(std::move(deviations)) / middle * 100.0;
+}
+
+void Bench_Runner::finish(Bench_Result&& result)
+{
+    print(result);
+    m_results.push_back(std::move(result));
+}
+
+void Bench_Runner::print_header() const
+{
+    std::print("{:<36} {:>12} {:>12} {:>12} {:>8} {:>10} {:>14}\n", "benchmark", "median ns", "min ns", "mean ns", "mad %", "ns/item", "items/s");
+}
+
+void Bench_Runner::print(const Bench_Result& result) const
+{
+    std::print(
+        "{:<36} {:>12.1f} {:>12.1f} {:>12.1f} {:>8.2f} {:>10.3f} {:>14.4g}\n",
+        result.m_name,
+        result.median(),
+        result.min(),
+        result.mean(),
+        result.mad_percent(),
+        result.ns_per_item(),
+        result.items_per_second()
+    );
+}
+
+// first line a shell command prints, empty if it couldn't run
+static std::string command_output(const char* command)
+{
+#if defined(_WIN32)
+    FILE* pipe = _popen(command, "r");
+#else
+    FILE* pipe = popen(command, "r");
+#endif
+
+    if (pipe == nullptr)
+        return {};
+
+    std::array<char, 256> line{};
+    const bool            read = std::fgets(line.data(), (i32)line.size(), pipe) != nullptr;
+
+#if defined(_WIN32)
+    _pclose(pipe);
+#else
+    pclose(pipe);
+#endif
+
+    std::string output = read ? line.data() : "";
+    while (!output.empty() && (output.back() == '\n' || output.back() == '\r'))
+        output.pop_back();
+
+    return output;
+}
+
+// the build can bake the commit in with ROPE_DEMO_COMMIT, otherwise we ask git about the working directory
+static std::string commit()
+{
+#if defined(ROPE_DEMO_COMMIT)
+    return ROPE_DEMO_COMMIT;
+#else
+#if defined(_WIN32)
+    constexpr const char* quiet = " 2>nul";
+#else
+    constexpr const char* quiet = " 2>/dev/null";
+#endif
+    std::string hash = command_output(std::format("git rev-parse HEAD{}", quiet).c_str());
+    if (hash.empty())
+        return "unknown";
+
+    // uncommitted changes mean the numbers don't belong to that commit alone
+    if (!command_output(std::format("git status --porcelain --untracked-files=no{}", quiet).c_str()).empty())
+        hash += "-dirty";
+
+    return hash;
+#endif
+}
+
+static std::string cpu_name()
+{
+    std::array<u32, 12> brand{};
+
+#if defined(_MSC_VER)
+    for (u32 i = 0u; i < 3u; ++i)
+        __cpuid((i32*)&brand[i * 4u], (i32)(0x80000002u + i));
+#elif defined(__x86_64__) || defined(__i386__)
+    for (u32 i = 0u; i < 3u; ++i)
+        __get_cpuid(0x80000002u + i, &brand[i * 4u], &brand[i * 4u + 1u], &brand[i * 4u + 2u], &brand[i * 4u + 3u]);
+#endif
+
+    // nul terminated unless it fills all 48 bytes, and padded with leading spaces on some cpus
+    std::string name((const char*)brand.data(), sizeof(brand));
+    name.erase(std::min(name.find('\0'), name.size()));
+    name.erase(0u, std::min(name.find_first_not_of(' '), name.size()));
+    return name.empty() ? "unknown" : name;
+}
+
+static std::string compiler_name()
+{
+#if defined(__clang__)
+    return std::format("clang {}.{}.{}", __clang_major__, __clang_minor__, __clang_patchlevel__);
+#elif defined(__GNUC__)
+    return std::format("gcc {}.{}.{}", __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__);
+#elif defined(_MSC_VER)
+    return std::format("msvc {}", _MSC_FULL_VER);
+#else
+    return "unknown";
+#endif
+}
+
+bool Bench_Runner::write_json(const std::filesystem::path& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        std::print("failed to open {} for the results\n", path.string());
+        return false;
+    }
+
+#if defined(NDEBUG)
+    constexpr const char* build = "release";
+#else
+    constexpr const char* build = "debug";
+#endif
+
+#if defined(_WIN32)
+    constexpr const char* os = "windows";
+#elif defined(__linux__)
+    constexpr const char* os = "linux";
+#else
+    constexpr const char* os = "other";
+#endif
+
+    std::string json = std::format(
+        "{{\n  \"metadata\": {{\n    \"commit\": \"{}\",\n    \"time\": {},\n    \"os\": \"{}\",\n    \"cpu\": \"{}\",\n"
+        "    \"hardware_threads\": {},\n    \"compiler\": \"{}\",\n    \"build\": \"{}\",\n    \"samples\": {},\n"
+        "    \"min_sample_ms\": {},\n    \"warmup_ms\": {}",
+        json_escape(commit()),
+        (i64)std::time(nullptr),
+        os,
+        json_escape(cpu_name()),
+        std::thread::hardware_concurrency(),
+        compiler_name(),
+        build,
+        m_options.samples,
+        m_options.min_sample_ms,
+        m_options.warmup_ms
+    );
+
+    for (const auto& [key, value] : m_metadata)
+        json += std::format(",\n    \"{}\": \"{}\"", json_escape(key), json_escape(value));
+
+    json += "\n  },\n  \"benchmarks\": [";
+
+    for (u32 i = 0u; i < m_results.size(); ++i)
+    {
+        const Bench_Result& result = m_results[i];
+
+        std::string samples{};
+        for (double sample : result.m_samples)
+            samples += std::format("{}{:.3f}", samples.empty() ? "" : ", ", sample);
+
+        json += std::format(
+            "{}\n    {{ \"name\": \"{}\", \"items\": {}, \"batch\": {}, \"median_ns\": {:.3f}, \"min_ns\": {:.3f}, \"mean_ns\": {:.3f}, "
+            "\"stddev_ns\": {:.3f}, \"ns_per_item\": {:.5f}, \"samples_ns\": [{}] }}",
+            i == 0u ? "" : ",",
+            json_escape(result.m_name),
+            result.m_items,
+            result.m_batch,
+            result.median(),
+            result.min(),
+            result.mean(),
+            result.stddev(),
+            result.ns_per_item(),
+            samples
+        );
+    }
+
+    json += "\n  ]\n}\n";
+    file << json;
+
+    return true;
+}
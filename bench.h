@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <utility>
+
+#include "types.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// keeps the compiler from proving a benchmarked result unused and deleting the work that produced it
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(_MSC_VER)
+    static const void* volatile sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+// the middle element, takes a copy since it partially sorts it
+double median_of(std::vector<double> values);
+
+struct Bench_Options
+{
+    double      warmup_ms     = 200.0; // run untimed first so caches, branch predictors and clocks settle
+    u32         samples       = 30u;   // timed samples, each one a batch of calls
+    double      min_sample_ms = 10.0;  // batches are sized so a sample takes at least this long, well above timer resolution
+    std::string filter{};              // only benchmarks whose name contains this run
+};
+
+// ns per call of every sample, statistics are over samples
+struct Bench_Result
+{
+    std::string         m_name;
+    u64                 m_items; // work done per call (nodes, pairs, pixels), for per-item rates
+    u64                 m_batch; // calls per sample
+    std::vector<double> m_samples;
+
+    double min() const;
+    double median() const;
+    double mean() const;
+    double stddev() const;
+
+    // median absolute deviation relative to the median, how noisy the run was
+    double mad_percent() const;
+
+    double ns_per_item() const { return median() / (double)m_items; }
+    double items_per_second() const { return 1e9 / ns_per_item(); }
+};
+
+class Bench_Runner
+{
+    Bench_Options                                    m_options;
+    std::vector<Bench_Result>                        m_results;
+    std::vector<std::pair<std::string, std::string>> m_metadata; // written next to the machine and build info
+
+    void finish(Bench_Result&& result);
+
+public:
+    Bench_Runner(const Bench_Options& options) : m_options(options), m_results(), m_metadata() {}
+
+    bool enabled(std::string_view name) const { return m_options.filter.empty() || name.find(m_options.filter) != std::string_view::npos; }
+
+    // setup runs untimed before every sample, for benchmarks whose state drifts (moving nodes) and needs putting back.
+    // fn is called directly in the timed loop, going through a std::function would add a few ns to every call
+    template <typename Setup, typename Fn>
+    void run(std::string_view name, u64 items, Setup&& setup, Fn&& fn)
+    {
+        if (!enabled(name))
+            return;
+
+        using clock = std::chrono::steady_clock;
+
+        // warm up and find out roughly how long a call takes at the same time
+        setup();
+
+        u64        warmup_calls = 0u;
+        const auto warmup_start = clock::now();
+        while (std::chrono::duration<double, std::milli>(clock::now() - warmup_start).count() < m_options.warmup_ms)
+        {
+            fn();
+            ++warmup_calls;
+        }
+
+        const double call_ms = std::chrono::duration<double, std::milli>(clock::now() - warmup_start).count() / warmup_calls;
+
+        Bench_Result result{std::string(name), std::max<u64>(items, 1u), std::max<u64>((u64)(m_options.min_sample_ms / call_ms), 1u), {}};
+        result.m_samples.reserve(m_options.samples);
+
+        for (u32 sample = 0u; sample < m_options.samples; ++sample)
+        {
+            setup();
+
+            const auto start = clock::now();
+            for (u64 call = 0u; call < result.m_batch; ++call)
+                fn();
+
+            result.m_samples.push_back(std::chrono::duration<double, std::nano>(clock::now() - start).count() / result.m_batch);
+        }
+
+        finish(std::move(result));
+    }
+
+    template <typename Fn>
+    void run(std::string_view name, u64 items, Fn&& fn)
+    {
+        run(name, items, [] {}, fn);
+    }
+
+    const std::vector<Bench_Result>& results() const { return m_results; }
+
+    void add_metadata(std::string key, std::string value) { m_metadata.emplace_back(std::move(key), std::move(value)); }
+
+    void print_header() const;
+    void print(const Bench_Result& result) const;
+
+    // every result with all of its samples, along with the commit, compiler, cpu and options the run used
+    bool write_json(const std::filesystem::path& path) const;
+};
+
+// runs are compared benchmark by benchmark with a two-sided mann-whitney u test on the samples. a benchmark has regressed
+// if the test is significant at alpha and its median got slower by more than threshold_percent. returns the number of
+// regressions, or -1 if either run couldn't be read
+i32 compare_bench_runs(const std::filesystem::path& baseline, const std::filesystem::path& current, double threshold_percent, double alpha);
+
+// every combination of ropes x nodes per rope x circles per rope x threads is simulated headless, one csv row each
+struct Sweep_Options
+{
+    std::vector<u32>      ropes{1u, 8u};
+    std::vector<u32>      nodes{64u, 512u, 4096u};
+    std::vector<u32>      circles{8u, 32u, 128u};
+    std::vector<u32>      threads{1u, 2u, 4u, 0u}; // 0 is every hardware thread
+    u32                   frames = 120u;           // measured, after every circle has spawned
+    std::filesystem::path csv{};
+};
+
+bool run_scaling_sweep(const Sweep_Options& options);
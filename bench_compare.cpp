@@ -0,0 +1,334 @@
+#include <print>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cctype>
+#include <charconv>
+#include <algorithm>
+
+#include "bench.h"
+
+// just enough json to read back what Bench_Runner::write_json writes, no escapes beyond \" and \\ and no unicode
+enum Json_Type : u8
+{
+    JSON_NULL = 0,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT,
+};
+
+struct Json_Value
+{
+    Json_Type                m_type = JSON_NULL;
+    double                   m_number{};
+    std::string              m_string{};
+    std::vector<Json_Value>  m_values{}; // array elements, or object values in the same order as m_keys
+    std::vector<std::string> m_keys{};
+
+    const Json_Value* find(std::string_view key) const
+    {
+        for (u32 i = 0u; i < m_keys.size(); ++i)
+        {
+            if (m_keys[i] == key)
+                return &m_values[i];
+        }
+
+        return nullptr;
+    }
+
+    std::string_view string_or(std::string_view key, std::string_view fallback) const
+    {
+        const Json_Value* value = find(key);
+        return value != nullptr && value->m_type == JSON_STRING ? std::string_view(value->m_string) : fallback;
+    }
+};
+
+class Json_Reader
+{
+    std::string_view m_text;
+    size_t           m_pos;
+
+    void skip_whitespace()
+    {
+        while (m_pos < m_text.size() && std::isspace((unsigned char)m_text[m_pos]))
+            ++m_pos;
+    }
+
+    bool consume(char c)
+    {
+        skip_whitespace();
+        if (m_pos >= m_text.size() || m_text[m_pos] != c)
+            return false;
+
+        ++m_pos;
+        return true;
+    }
+
+    bool parse_string(std::string& out)
+    {
+        if (!consume('"'))
+            return false;
+
+        while (m_pos < m_text.size() && m_text[m_pos] != '"')
+        {
+            if (m_text[m_pos] == '\\' && m_pos + 1u < m_text.size())
+                ++m_pos;
+
+            out += m_text[m_pos++];
+        }
+
+        return consume('"');
+    }
+
+    bool parse_literal(std::string_view literal)
+    {
+        if (m_text.substr(m_pos, literal.size()) != literal)
+            return false;
+
+        m_pos += literal.size();
+        return true;
+    }
+
+public:
+    Json_Reader(std::string_view text) : m_text(text), m_pos() {}
+
+    bool parse(Json_Value& out)
+    {
+        skip_whitespace();
+        if (m_pos >= m_text.size())
+            return false;
+
+        const char c = m_text[m_pos];
+
+        if (c == '{')
+        {
+            out.m_type = JSON_OBJECT;
+            ++m_pos;
+
+            if (consume('}'))
+                return true;
+
+            do
+            {
+                std::string key{};
+                if (!parse_string(key) || !consume(':'))
+                    return false;
+
+                out.m_keys.push_back(std::move(key));
+                if (!parse(out.m_values.emplace_back()))
+                    return false;
+            } while (consume(','));
+
+            return consume('}');
+        }
+
+        if (c == '[')
+        {
+            out.m_type = JSON_ARRAY;
+            ++m_pos;
+
+            if (consume(']'))
+                return true;
+
+            do
+            {
+                if (!parse(out.m_values.emplace_back()))
+                    return false;
+            } while (consume(','));
+
+            return consume(']');
+        }
+
+        if (c == '"')
+        {
+            out.m_type = JSON_STRING;
+            return parse_string(out.m_string);
+        }
+
+        if (c == 't' || c == 'f')
+        {
+            out.m_type   = JSON_BOOL;
+            out.m_number = c == 't';
+            return parse_literal(c == 't' ? "true" : "false");
+        }
+
+        if (c == 'n')
+            return parse_literal("null");
+
+        out.m_type        = JSON_NUMBER;
+        const auto result = std::from_chars(m_text.data() + m_pos, m_text.data() + m_text.size(), out.m_number);
+        m_pos             = result.ptr - m_text.data();
+
+        return result.ec == std::errc();
+    }
+};
+
+static bool read_run(const std::filesystem::path& path, Json_Value& run)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::print("failed to open {}\n", path.string());
+        return false;
+    }
+
+    std::stringstream text{};
+    text << file.rdbuf();
+
+    const std::string contents = text.str();
+    if (!Json_Reader(contents).parse(run) || run.m_type != JSON_OBJECT || run.find("benchmarks") == nullptr)
+    {
+        std::print("{} isn't a rope_bench result\n", path.string());
+        return false;
+    }
+
+    return true;
+}
+
+static std::vector<double> samples_of(const Json_Value& benchmark)
+{
+    std::vector<double> samples{};
+
+    const Json_Value* values = benchmark.find("samples_ns");
+    if (values == nullptr)
+        return samples;
+
+    for (const auto& value : values->m_values)
+        samples.push_back(value.m_number);
+
+    return samples;
+}
+
+// two-sided p-value of the mann-whitney u test, through the normal approximation with a tie and continuity correction.
+// it makes no assumption about how the timings are distributed (they're skewed, with a long tail of interrupted samples)
+// and is close enough to exact from around 8 samples a side
+static double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b)
+{
+    struct Ranked
+    {
+        double m_value;
+        bool   m_from_a;
+    };
+
+    std::vector<Ranked> all{};
+    all.reserve(a.size() + b.size());
+
+    for (double value : a)
+        all.push_back({value, true});
+
+    for (double value : b)
+        all.push_back({value, false});
+
+    std::sort(all.begin(), all.end(), [](const Ranked& lhs, const Ranked& rhs) { return lhs.m_value < rhs.m_value; });
+
+    // tied values share the average of the ranks they span
+    double rank_sum_a = 0.0, ties = 0.0;
+    for (size_t first = 0u; first < all.size();)
+    {
+        size_t last = first;
+        while (last + 1u < all.size() && all[last + 1u].m_value == all[first].m_value)
+            ++last;
+
+        const double rank  = (first + last) / 2.0 + 1.0;
+        const double count = (double)(last - first + 1u);
+
+        for (size_t i = first; i <= last; ++i)
+            rank_sum_a += all[i].m_from_a ? rank : 0.0;
+
+        ties  += count * count * count - count;
+        first  = last + 1u;
+    }
+
+    const double n_a = (double)a.size(), n_b = (double)b.size(), n = n_a + n_b;
+
+    const double u     = rank_sum_a - n_a * (n_a + 1.0) / 2.0;
+    const double mean  = n_a * n_b / 2.0;
+    const double sigma = std::sqrt(n_a * n_b / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0))));
+
+    if (sigma <= 0.0)
+        return 1.0;
+
+    const double z = std::max(std::abs(u - mean) - 0.5, 0.0) / sigma;
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+i32 compare_bench_runs(const std::filesystem::path& baseline, const std::filesystem::path& current, double threshold_percent, double alpha)
+{
+    Json_Value baseline_run{}, current_run{};
+    if (!read_run(baseline, baseline_run) || !read_run(current, current_run))
+        return -1;
+
+    static const Json_Value empty{};
+
+    const Json_Value* baseline_metadata = baseline_run.find("metadata");
+    const Json_Value* current_metadata  = current_run.find("metadata");
+    const Json_Value& old_info          = baseline_metadata != nullptr ? *baseline_metadata : empty;
+    const Json_Value& new_info          = current_metadata != nullptr ? *current_metadata : empty;
+
+    std::print("baseline: {} ({}, {})\n", old_info.string_or("commit", "?"), old_info.string_or("cpu", "?"), old_info.string_or("compiler", "?"));
+    std::print("current:  {} ({}, {})\n", new_info.string_or("commit", "?"), new_info.string_or("cpu", "?"), new_info.string_or("compiler", "?"));
+
+    // numbers from different machines or builds say more about those than about the code
+    for (std::string_view key : {"cpu", "compiler", "build"})
+    {
+        if (old_info.string_or(key, "?") != new_info.string_or(key, "?"))
+            std::print("warning: the runs have a different {}\n", key);
+    }
+
+    std::print("{:<36} {:>12} {:>12} {:>9} {:>9}  {}\n", "benchmark", "baseline ns", "current ns", "change", "p", "verdict");
+
+    i32 regressions = 0;
+
+    for (const auto& benchmark : current_run.find("benchmarks")->m_values)
+    {
+        const std::string_view name = benchmark.string_or("name", "");
+
+        const Json_Value* match = nullptr;
+        for (const auto& candidate : baseline_run.find("benchmarks")->m_values)
+        {
+            if (candidate.string_or("name", "") == name)
+                match = &candidate;
+        }
+
+        if (match == nullptr)
+        {
+            std::print("{:<36} not in the baseline\n", name);
+            continue;
+        }
+
+        const std::vector<double> old_samples = samples_of(*match);
+        const std::vector<double> new_samples = samples_of(benchmark);
+        if (old_samples.size() < 2u || new_samples.size() < 2u)
+        {
+            std::print("{:<36} not enough samples\n", name);
+            continue;
+        }
+
+        const double old_median = median_of(old_samples);
+        const double new_median = median_of(new_samples);
+        const double change     = (new_median - old_median) / old_median * 100.0;
+        const double p          = mann_whitney_p(old_samples, new_samples);
+
+        // a significant difference smaller than the threshold is real but too small to act on
+        const char* verdict = "";
+        if (p < alpha && change > threshold_percent)
+        {
+            verdict = "REGRESSED";
+            ++regressions;
+        }
+
+        else if (p < alpha && change < -threshold_percent)
+            verdict = "improved";
+
+        std::print("{:<36} {:>12.1f} {:>12.1f} {:>+8.2f}% {:>9.2g}  {}\n", name, old_median, new_median, change, p, verdict);
+    }
+
+    std::print("{} regression(s) beyond {}% at p < {}\n", regressions, threshold_percent, alpha);
+
+    return regressions;
+}
@@ -0,0 +1,457 @@
+#include <print>
+#include <charconv>
+#include <optional>
+
+#include "render.h"
+#include "gl_state.h"
+#include "rope.h"
+#include "rng.h"
+#include "bench.h"
+#include "perf_counters.h"
+
+// microbenchmarks of the simulation kernels and the blur, each at a few problem sizes. nothing here opens a window, the
+// blur renders through SDL's offscreen driver like rope_demo --headless does
+
+template <typename T>
+bool parse_number(const char* str, T& out)
+{
+    const std::string_view view = str;
+    return std::from_chars(view.data(), view.data() + view.size(), out).ec == std::errc();
+}
+
+// comma separated, e.g. 1,8,64
+static std::vector<u32> parse_list(std::string_view list)
+{
+    std::vector<u32> values{};
+
+    while (!list.empty())
+    {
+        const size_t comma = list.find(',');
+        const auto   item  = list.substr(0u, comma);
+
+        u32 value = 0u;
+        if (std::from_chars(item.data(), item.data() + item.size(), value).ec == std::errc())
+            values.push_back(value);
+
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1u);
+    }
+
+    return values;
+}
+
+constexpr float timestep = 1.0f / 60.0f;
+
+// far enough away that the clamp in constrain never kicks in
+constexpr glm::vec2 unbounded_min = glm::vec2(-1e9f, -1e9f);
+constexpr glm::vec2 unbounded_max = glm::vec2(1e9f, 1e9f);
+
+constexpr std::array<u32, 3> node_counts   = {32u, 1024u, 32768u};
+constexpr std::array<u32, 2> circle_counts = {4u, 32u};
+
+// a straight rope along x with every segment stretched by stretch, the first node is static like the demo's
+static std::vector<Node> make_nodes(u32 count, float stretch = 1.0f)
+{
+    std::vector<Node> nodes{};
+    nodes.reserve(count);
+
+    for (u32 i = 0u; i < count; ++i)
+        nodes.push_back(Node(i == 0u, glm::vec2((float)i * Node::m_rest_length * stretch, 0.0f)));
+
+    return nodes;
+}
+
+// circles spread evenly along the rope, so roughly the same share of nodes touch one at every size
+static std::vector<Circle> make_circles(u32 count, const std::vector<Node>& nodes)
+{
+    std::vector<Circle> circles{};
+    circles.reserve(count);
+
+    for (u32 i = 0u; i < count; ++i)
+    {
+        circles.push_back(Circle(i, glm::vec2(0.0f, 0.0f), glm::vec2(1920.0f, 1080.0f)));
+        circles.back().m_pos = nodes[(u64)i * nodes.size() / count].m_pos;
+    }
+
+    return circles;
+}
+
+// a node kernel, with --perf-counters every call is counted towards stage and the counts are printed under the result.
+// the counter reads add a syscall per call, so only the timings of runs without it are comparable
+template <typename Setup, typename Fn>
+static void run_kernel(Bench_Runner& runner, std::string_view name, Perf_Stage stage, u64 items, Setup&& setup, Fn&& fn)
+{
+    runner.run(
+        name,
+        items,
+        setup,
+        [&]
+        {
+            Perf_Scope perf(stage, items);
+            fn();
+        }
+    );
+
+    g_perf_counters.print();
+    g_perf_counters.reset();
+}
+
+static void bench_nodes(Bench_Runner& runner)
+{
+    for (u32 count : node_counts)
+    {
+        const std::vector<Node> initial = make_nodes(count);
+        std::vector<Node>       nodes   = initial;
+
+        run_kernel(
+            runner,
+            std::format("node_simulate/{}", count),
+            PERF_STAGE_NODE_SIMULATE,
+            count,
+            [&] { nodes = initial; },
+            [&]
+            {
+                for (auto& node : nodes)
+                    node.simulate(timestep);
+
+                do_not_optimize(nodes.data());
+            }
+        );
+    }
+
+    for (u32 count : node_counts)
+    {
+        // stretched so every sweep has something to correct, it converges over a sample which is what the solver sees too
+        const std::vector<Node> initial = make_nodes(count, 1.5f);
+        std::vector<Node>       nodes   = initial;
+
+        run_kernel(
+            runner,
+            std::format("node_constrain/{}", count),
+            PERF_STAGE_NODE_CONSTRAIN,
+            count - 1u,
+            [&] { nodes = initial; },
+            [&]
+            {
+                float residual = 0.0f;
+                for (u32 i = 0u; i + 1u < count; ++i)
+                    residual = std::max(residual, nodes[i].constrain(nodes[i + 1u], unbounded_min, unbounded_max));
+
+                do_not_optimize(residual);
+            }
+        );
+    }
+
+    for (u32 count : node_counts)
+    {
+        for (u32 circles_count : circle_counts)
+        {
+            const std::vector<Node>   initial = make_nodes(count);
+            const std::vector<Circle> circles = make_circles(circles_count, initial);
+            std::vector<Node>         nodes   = initial;
+
+            // per node, each one is tested against every circle
+            run_kernel(
+                runner,
+                std::format("node_collide/{}x{}", count, circles_count),
+                PERF_STAGE_NODE_COLLIDE,
+                count,
+                [&] { nodes = initial; },
+                [&]
+                {
+                    u32 contacts = 0u;
+                    for (auto& node : nodes)
+                    {
+                        for (const auto& circle : circles)
+                            contacts += node.collide(circle);
+                    }
+
+                    do_not_optimize(contacts);
+                }
+            );
+        }
+    }
+}
+
+static void bench_circles(Bench_Runner& runner)
+{
+    for (u32 count : node_counts)
+    {
+        const std::vector<Circle> initial = make_circles(count, make_nodes(count));
+        std::vector<Circle>       circles = initial;
+
+        // a tiny timestep keeps them from reaching the end of their path during a sample, the work per update is the same
+        runner.run(
+            std::format("circle_update/{}", count),
+            count,
+            [&] { circles = initial; },
+            [&]
+            {
+                for (auto& circle : circles)
+                    circle.update(1e-4f);
+
+                do_not_optimize(circles.data());
+            }
+        );
+    }
+}
+
+static void bench_rope(Bench_Runner& runner)
+{
+    const glm::vec2 min = glm::vec2(0.0f, 0.0f);
+    const glm::vec2 max = glm::vec2(1920.0f, 1080.0f);
+
+    for (u32 count : node_counts)
+    {
+        std::optional<Rope> rope{};
+
+        // the whole step as the demo runs it: circles, then every node collided, integrated and constrained 16 times in turn
+        runner.run(
+            std::format("rope_simulate/{}", count),
+            count,
+            [&] { rope.emplace(min, max, Rope_Settings{}, count); },
+            [&]
+            {
+                rope->simulate(timestep, rope->m_nodes[0].m_pos);
+                do_not_optimize(rope->m_nodes.data());
+            }
+        );
+    }
+}
+
+// gpu work, timed from submission until glFinish returns. everything gl it creates is gone again before it returns
+static void bench_blur_cases(Bench_Runner& runner)
+{
+    // a broken context can give us null
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    if (!renderer)
+        renderer = "unknown";
+
+    std::print("renderer: {}\n", renderer);
+    runner.add_metadata("renderer", renderer);
+
+    Shaders shaders{};
+    if (!shaders.load_shaders())
+    {
+        std::print("skipping the blur, couldn't load the shaders\n");
+        return;
+    }
+
+    constexpr std::array<u32, 3> sizes = {256u, 512u, 1024u};
+
+    struct Blur_Case
+    {
+        Blur_Mode   m_mode;
+        u32         m_strength;
+        const char* m_name;
+    };
+
+    constexpr std::array<Blur_Case, 4> cases = {{
+        {BLUR_GAUSSIAN, 4u, "gaussian_r4"},
+        {BLUR_GAUSSIAN, 16u, "gaussian_r16"},
+        {BLUR_DUAL_FILTER, 3u, "dual_filter_d3"},
+        {BLUR_DUAL_FILTER, 6u, "dual_filter_d6"},
+    }};
+
+    for (u32 size : sizes)
+    {
+        // noise so nothing can be skipped over flat regions
+        RNG              rng(g_rng_seed, size);
+        std::vector<u32> pixels(size * size);
+        for (auto& pixel : pixels)
+            pixel = rng.get_random<u32>(0u, 0xFFFFFFFFu);
+
+        GLuint input = 0u;
+        glGenTextures(1, &input);
+        glBindTexture(GL_TEXTURE_2D, input);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, (GLsizei)size, (GLsizei)size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        g_gl_state.invalidate();
+
+        for (const auto& blur_case : cases)
+        {
+            const std::string name = std::format("blur_{}/{}", blur_case.m_name, size);
+            if (!runner.enabled(name))
+                continue;
+
+            Blur blur(shaders, glm::ivec2(size), glm::ivec2(size), blur_case.m_mode, blur_case.m_strength);
+
+            // per output pixel
+            runner.run(
+                name,
+                (u64)size * size,
+                [&]
+                {
+                    do_not_optimize(blur.apply(input));
+                    glFinish();
+                }
+            );
+        }
+
+        glDeleteTextures(1, &input);
+        g_gl_state.invalidate();
+    }
+}
+
+// sets up a context for the blur, every way out tears down whatever was created
+static void bench_blur(Bench_Runner& runner)
+{
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    SDL_setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    SDL_setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+    {
+        std::print("skipping the blur, {}\n", SDL_GetError());
+        return;
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+    SDL_Window*   window = SDL_CreateWindow("rope_bench", 64, 64, (SDL_WindowFlags)(SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN));
+    SDL_GLContext gl_ctx = window != nullptr ? SDL_GL_CreateContext(window) : nullptr;
+
+    if (gl_ctx != nullptr)
+    {
+        SDL_GL_MakeCurrent(window, gl_ctx);
+
+        // through SDL, so the functions come from the same library as the context
+        if (gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress) != 0)
+            bench_blur_cases(runner);
+        else
+            std::print("skipping the blur, couldn't load the OpenGL functions\n");
+
+        SDL_GL_DeleteContext(gl_ctx);
+    }
+    else
+        std::print("skipping the blur, {}\n", SDL_GetError());
+
+    if (window != nullptr)
+        SDL_DestroyWindow(window);
+
+    SDL_Quit();
+}
+
+int main(int argc, char** argv)
+{
+    Bench_Options         options{};
+    Sweep_Options         sweep{};
+    bool                  gpu           = true;
+    bool                  perf_counters = false;
+    std::filesystem::path json{};
+
+    // --compare
+    std::filesystem::path baseline{}, current{};
+    double                threshold = 5.0;
+    double                alpha     = 0.01;
+
+    // same circles and blur input every run unless asked otherwise, so two runs measure the same work
+    g_rng_seed = 1u;
+
+    // --filter <substring>: only run benchmarks whose name contains it, e.g. node_collide or /1024
+    // --samples <n>, --warmup <ms>, --min-sample <ms>: how long each benchmark is measured for
+    // --seed <seed>: rng seed for the circles and the blur's input
+    // --no-gpu: skip the blur, for machines without any GL driver
+    // --perf-counters: count hardware events in the node_collide, node_simulate and node_constrain kernels (linux only),
+    //   printed under each result
+    // --sweep <csv path>: run the scaling sweep instead of the microbenchmarks, the grid is set with
+    //   --ropes, --nodes, --circles and --threads <comma separated list>, and --frames <n> measured per configuration
+    // --json <path>: write every result with its samples, the commit and the machine it ran on
+    // --compare <baseline json> <current json>: compare two --json runs instead of benchmarking, exits with 1 if any
+    //   benchmark regressed by more than --threshold <percent> (5) with a mann-whitney p below --alpha (0.01)
+    for (i32 i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--filter" && i + 1 < argc)
+            options.filter = argv[++i];
+
+        else if (arg == "--samples" && i + 1 < argc)
+            parse_number(argv[++i], options.samples);
+
+        else if (arg == "--warmup" && i + 1 < argc)
+            parse_number(argv[++i], options.warmup_ms);
+
+        else if (arg == "--min-sample" && i + 1 < argc)
+            parse_number(argv[++i], options.min_sample_ms);
+
+        else if (arg == "--seed" && i + 1 < argc)
+            parse_number(argv[++i], g_rng_seed);
+
+        else if (arg == "--no-gpu")
+            gpu = false;
+
+        else if (arg == "--perf-counters")
+            perf_counters = true;
+
+        else if (arg == "--sweep" && i + 1 < argc)
+            sweep.csv = argv[++i];
+
+        else if (arg == "--ropes" && i + 1 < argc)
+            sweep.ropes = parse_list(argv[++i]);
+
+        else if (arg == "--nodes" && i + 1 < argc)
+            sweep.nodes = parse_list(argv[++i]);
+
+        else if (arg == "--circles" && i + 1 < argc)
+            sweep.circles = parse_list(argv[++i]);
+
+        else if (arg == "--threads" && i + 1 < argc)
+            sweep.threads = parse_list(argv[++i]);
+
+        else if (arg == "--frames" && i + 1 < argc)
+            parse_number(argv[++i], sweep.frames);
+
+        else if (arg == "--json" && i + 1 < argc)
+            json = argv[++i];
+
+        else if (arg == "--compare" && i + 2 < argc)
+        {
+            baseline = argv[++i];
+            current  = argv[++i];
+        }
+
+        else if (arg == "--threshold" && i + 1 < argc)
+            parse_number(argv[++i], threshold);
+
+        else if (arg == "--alpha" && i + 1 < argc)
+            parse_number(argv[++i], alpha);
+    }
+
+    if (!baseline.empty())
+        return compare_bench_runs(baseline, current, threshold, alpha) == 0 ? 0 : 1;
+
+    if (!sweep.csv.empty())
+    {
+        if (sweep.ropes.empty() || sweep.nodes.empty() || sweep.circles.empty() || sweep.threads.empty())
+        {
+            std::print("the sweep needs at least one value for --ropes, --nodes, --circles and --threads\n");
+            return 1;
+        }
+
+        return run_scaling_sweep(sweep) ? 0 : 1;
+    }
+
+    options.samples = std::max(options.samples, 2u);
+
+    if (perf_counters)
+        g_perf_counters.init();
+
+    Bench_Runner runner(options);
+    runner.add_metadata("seed", std::to_string(g_rng_seed));
+    runner.print_header();
+
+    bench_nodes(runner);
+    bench_circles(runner);
+    bench_rope(runner);
+
+    if (gpu)
+        bench_blur(runner);
+
+    if (!json.empty() && !runner.write_json(json))
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include <print>
+#include <format>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif !defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "render.h"
+#include "rope.h"
+#include "bench.h"
+#include "thread_pool.h"
+
+// lets each configuration's peak be measured on its own, linux only. elsewhere the peak only ever grows, so it's the
+// largest configuration run so far
+static void reset_peak_rss()
+{
+#if defined(__linux__)
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+// KiB
+static u64 peak_rss()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+    return counters.PeakWorkingSetSize / 1024u;
+#elif defined(__linux__)
+    std::ifstream status("/proc/self/status");
+
+    std::string line{};
+    while (std::getline(status, line))
+    {
+        if (line.starts_with("VmHWM:"))
+            return std::stoull(line.substr(6u));
+    }
+
+    return 0u;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    // bytes on macos
+    return (u64)usage.ru_maxrss / 1024u;
+#endif
+}
+
+struct Sweep_Config
+{
+    u32 m_ropes;
+    u32 m_nodes;
+    u32 m_circles;
+    u32 m_threads;
+};
+
+struct Sweep_Row
+{
+    std::array<double, SIM_STAGE_MAX> m_stage_ms; // per frame, summed over every rope
+    double                            m_frame_ms;
+    double                            m_p95_ms;
+    double                            m_node_steps; // nodes simulated per second
+    double                            m_candidate_pairs;
+    double                            m_contacts;
+    u64                               m_peak_rss;
+};
+
+static Sweep_Row run_config(const Sweep_Config& config, u32 frames)
+{
+    constexpr float     timestep = 1.0f / 60.0f;
+    constexpr glm::vec2 min      = glm::vec2(0.0f, 0.0f);
+    constexpr glm::vec2 max      = glm::vec2(1920.0f, 1080.0f);
+
+    reset_peak_rss();
+
+    // a circle spawns every step until they're all out, they cross the screen far slower than the run lasts
+    Rope_Settings settings{};
+    settings.threads        = config.m_threads;
+    settings.max_circles    = config.m_circles;
+    settings.spawn_interval = 0.0f;
+
+    // each rope starts in its own band with its own circles, see make_ropes
+    std::vector<Rope> ropes = make_ropes(min, max, settings, config.m_ropes, config.m_nodes);
+
+    // nothing is pinned, every rope's static node stays where it was laid out. the ropes are spread over the threads
+    auto step = [&]() { return simulate_ropes(ropes, timestep, glm::vec2(-FLT_MAX, -FLT_MAX), glm::vec2(), config.m_threads); };
+
+    for (u32 frame = 0u; frame < config.m_circles + 1u; ++frame)
+        step();
+
+    Sweep_Row           row{};
+    std::vector<double> frame_ms{};
+    frame_ms.reserve(frames);
+
+    for (u32 frame = 0u; frame < frames; ++frame)
+    {
+        const auto       start = std::chrono::steady_clock::now();
+        const Rope_Stats stats = step();
+        frame_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        for (u32 stage = 0u; stage < SIM_STAGE_MAX; ++stage)
+            row.m_stage_ms[stage] += stats.m_stage_ms[stage];
+
+        row.m_candidate_pairs += stats.m_candidate_pairs;
+        row.m_contacts        += stats.m_contacts;
+    }
+
+    double total_ms = 0.0;
+    for (double ms : frame_ms)
+        total_ms += ms;
+
+    for (auto& stage_ms : row.m_stage_ms)
+        stage_ms /= frames;
+
+    row.m_frame_ms         = total_ms / frames;
+    row.m_candidate_pairs /= frames;
+    row.m_contacts        /= frames;
+    row.m_node_steps       = (double)config.m_ropes * config.m_nodes * frames / (total_ms / 1000.0);
+
+    std::sort(frame_ms.begin(), frame_ms.end());
+    row.m_p95_ms = frame_ms[std::min(frame_ms.size() - 1u, (size_t)(0.95 * frame_ms.size()))];
+
+    row.m_peak_rss = peak_rss();
+
+    return row;
+}
+
+bool run_scaling_sweep(const Sweep_Options& options)
+{
+    std::ofstream file(options.csv, std::ios::trunc);
+    if (!file)
+    {
+        std::print("failed to open {} for the sweep\n", options.csv.string());
+        return false;
+    }
+
+    // every worker any configuration asks for is started up front, see Thread_Pool
+    const u32 hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const u32 max_threads      = std::max(*std::max_element(options.threads.begin(), options.threads.end()), hardware_threads);
+    g_thread_pool.init(max_threads);
+
+    // --frames 0 still measures one, the csv says how many actually ran
+    const u32 frames = std::max(options.frames, 1u);
+
+    std::string header = "ropes,nodes_per_rope,circles_per_rope,threads,frames,frame_ms,frame_p95_ms,node_steps_per_s";
+    for (auto name : sim_stage_names)
+        header += std::format(",{}_ms", name);
+
+    header += ",candidate_pairs,contacts,peak_rss_kib\n";
+    file << header;
+
+    std::print("{:>5} {:>7} {:>7} {:>7} {:>10} {:>14} {:>12}\n", "ropes", "nodes", "circles", "threads", "frame ms", "node steps/s", "peak rss KiB");
+
+    for (u32 ropes : options.ropes)
+    {
+        for (u32 nodes : options.nodes)
+        {
+            for (u32 circles : options.circles)
+            {
+                for (u32 threads : options.threads)
+                {
+                    const Sweep_Config config = {ropes, std::max(nodes, 2u), circles, threads == 0u ? hardware_threads : threads};
+                    const Sweep_Row    row    = run_config(config, frames);
+
+                    std::string line = std::format(
+                        "{},{},{},{},{},{:.4f},{:.4f},{:.0f}",
+                        config.m_ropes,
+                        config.m_nodes,
+                        config.m_circles,
+                        config.m_threads,
+                        frames,
+                        row.m_frame_ms,
+                        row.m_p95_ms,
+                        row.m_node_steps
+                    );
+
+                    for (double stage_ms : row.m_stage_ms)
+                        line += std::format(",{:.4f}", stage_ms);
+
+                    line += std::format(",{:.0f},{:.0f},{}\n", row.m_candidate_pairs, row.m_contacts, row.m_peak_rss);
+
+                    // flushed every row so a sweep that's cut short still leaves everything it measured
+                    file << line << std::flush;
+
+                    std::print(
+                        "{:>5} {:>7} {:>7} {:>7} {:>10.3f} {:>14.4g} {:>12}\n",
+                        config.m_ropes,
+                        config.m_nodes,
+                        config.m_circles,
+                        config.m_threads,
+                        row.m_frame_ms,
+                        row.m_node_steps,
+                        row.m_peak_rss
+                    );
+                }
+            }
+        }
+    }
+
+    g_thread_pool.shutdown();
+
+    return true;
+}
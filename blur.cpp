@@ -0,0 +1,163 @@
+#include <print>
+#include <format>
+#include <string>
+
+#include "blur.h"
+#include "gl_state.h"
+
+Blur::Blur(Shaders& shaders, glm::ivec2 size, glm::ivec2 output_size, Blur_Mode mode, u32 strength) :
+    m_mode(mode), m_strength(strength), m_size(size), m_output_size(output_size), m_vao(), m_targets(), m_shaders(&shaders), m_passes()
+{
+    // the fullscreen triangle is generated from gl_VertexID, core profile still wants a vao bound to draw
+    glGenVertexArrays(1, &m_vao);
+
+    set_mode(mode, strength);
+}
+
+void Blur::load_passes()
+{
+    if (m_mode == BLUR_DUAL_FILTER)
+    {
+        const std::array<Shader_Define, 1> upsample = {{{"DUAL_FILTER_UPSAMPLE", "1"}}};
+
+        m_passes[0] = m_shaders->find("dual_filter");
+        m_passes[1] = m_shaders->get_variant("dual_filter", upsample);
+        return;
+    }
+
+    // the kernel goes in as constant arrays with a constant trip count so the compiler can unroll the loop and fold the weights
+    const Gaussian_Kernel& kernel = gaussian_kernels[m_strength];
+
+    std::string weights{}, offsets{};
+    for (u32 i = 0u; i < kernel.m_taps; ++i)
+    {
+        weights += std::format("{}{:.8e}", i == 0u ? "" : ", ", kernel.m_weights[i]);
+        offsets += std::format("{}{:.8e}", i == 0u ? "" : ", ", kernel.m_offsets[i]);
+    }
+
+    for (u32 pass = 0u; pass < 2u; ++pass)
+    {
+        const std::array<Shader_Define, 4> defines = {{
+            {"BLUR_TAPS", std::to_string(kernel.m_taps)},
+            {"BLUR_WEIGHTS", weights},
+            {"BLUR_OFFSETS", offsets},
+            {"BLUR_DIRECTION", pass == 0u ? "vec2(1.0, 0.0)" : "vec2(0.0, 1.0)"},
+        }};
+
+        m_passes[pass] = m_shaders->get_variant("gaussian", defines);
+    }
+}
+
+void Blur::create_targets()
+{
+    // gaussian ping-pongs between two full size targets, the dual filter needs a full size output and one target per level
+    const u32 count = m_mode == BLUR_GAUSSIAN ? 2u : 1u + m_strength;
+
+    for (u32 i = 0u; i < count; ++i)
+    {
+        Target target{};
+
+        // every pyramid level is half the size of the one above it, the last upsample goes straight to the output size
+        if (m_mode == BLUR_GAUSSIAN)
+            target.m_size = m_size;
+
+        else
+            target.m_size = i == 0u ? m_output_size : glm::max(m_size >> glm::ivec2((i32)i), glm::ivec2(1));
+
+        glGenFramebuffers(1, &target.m_fbo);
+        glGenTextures(1, &target.m_texture);
+
+        // both blurs rely on linear filtering to blend several texels with one fetch
+        g_gl_state.bind_texture(target.m_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, target.m_size.x, target.m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+        g_gl_state.bind_framebuffer(target.m_fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.m_texture, 0);
+
+        if (auto res = glCheckFramebufferStatus(GL_FRAMEBUFFER); res != GL_FRAMEBUFFER_COMPLETE)
+            std::print("blur framebuffer incomplete: 0x{:X}\n", res);
+
+        m_targets.push_back(target);
+    }
+}
+
+void Blur::destroy_targets()
+{
+    for (auto& target : m_targets)
+    {
+        glDeleteFramebuffers(1, &target.m_fbo);
+        glDeleteTextures(1, &target.m_texture);
+    }
+
+    m_targets.clear();
+
+    // deleting bound objects silently rebinds 0 and the names can be handed out again
+    g_gl_state.invalidate();
+}
+
+void Blur::set_mode(Blur_Mode mode, u32 strength)
+{
+    m_mode     = mode;
+    m_strength = std::min(std::max(strength, 1u), mode == BLUR_GAUSSIAN ? Gaussian_Kernel::max_radius : max_depth);
+
+    load_passes();
+    destroy_targets();
+    create_targets();
+}
+
+void Blur::draw(GLuint src, const Target& dst)
+{
+    g_gl_state.bind_framebuffer(dst.m_fbo);
+    g_gl_state.viewport(0, 0, dst.m_size.x, dst.m_size.y);
+    g_gl_state.bind_texture(src);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+GLuint Blur::apply_gaussian(GLuint texture)
+{
+    // texture -> horizontal -> m_targets[0] -> vertical -> m_targets[1]
+    for (u32 pass = 0u; pass < 2u; ++pass)
+    {
+        const Shader& shader = m_shaders->get(m_passes[pass]);
+
+        g_gl_state.use_program(shader.m_shader_program);
+        glUniform1i(shader.location(UNIFORM_TEX), 0);
+        draw(pass == 0u ? texture : m_targets[0].m_texture, m_targets[pass]);
+    }
+
+    return m_targets[1].m_texture;
+}
+
+GLuint Blur::apply_dual_filter(GLuint texture)
+{
+    const Shader& down = m_shaders->get(m_passes[0]);
+    const Shader& up   = m_shaders->get(m_passes[1]);
+
+    // down the pyramid, texture -> m_targets[1] -> ... -> m_targets[depth]
+    g_gl_state.use_program(down.m_shader_program);
+    glUniform1i(down.location(UNIFORM_TEX), 0);
+    for (u32 i = 1u; i < m_targets.size(); ++i)
+        draw(i == 1u ? texture : m_targets[i - 1u].m_texture, m_targets[i]);
+
+    // and back up, m_targets[depth] -> ... -> m_targets[0]
+    g_gl_state.use_program(up.m_shader_program);
+    glUniform1i(up.location(UNIFORM_TEX), 0);
+    for (u32 i = (u32)m_targets.size() - 1u; i > 0u; --i)
+        draw(m_targets[i].m_texture, m_targets[i - 1u]);
+
+    return m_targets[0].m_texture;
+}
+
+GLuint Blur::apply(GLuint texture)
+{
+    // ImGui sets up everything it needs itself, so nothing gets unbound afterwards
+    g_gl_state.set_enabled(GL_CAP_BLEND, false);
+    g_gl_state.set_enabled(GL_CAP_SCISSOR_TEST, false);
+    g_gl_state.bind_vertex_array(m_vao);
+
+    return m_mode == BLUR_GAUSSIAN ? apply_gaussian(texture) : apply_dual_filter(texture);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shaders.h"
+#include "types.h"
+
+// one side of a separable gaussian, adjacent taps are merged into a single bilinear fetch placed between them
+// see https://www.rastergrid.com/blog/2010/09/efficient-gaussian-blur-with-linear-sampling/
+struct Gaussian_Kernel
+{
+    static constexpr u32 max_radius = 16u;
+    static constexpr u32 max_taps   = 1u + (max_radius + 1u) / 2u;
+
+    std::array<float, max_taps> m_weights{};
+    std::array<float, max_taps> m_offsets{};
+    u32                         m_taps{};
+};
+
+// weights come from a row of pascal's triangle, it converges on a gaussian and needs no exp()
+// the row is two wider than the kernel so the near-zero outermost coefficients can be dropped
+constexpr Gaussian_Kernel make_gaussian_kernel(u32 radius)
+{
+    radius = std::min(std::max(radius, 1u), Gaussian_Kernel::max_radius);
+
+    const u32 row = radius * 2u + 2u;
+
+    // binomial coefficients for the center and one side, coefficients[i] is i texels away from the center
+    std::array<double, Gaussian_Kernel::max_radius + 1u> coefficients{};
+
+    double coefficient = 1.0, total = 0.0;
+    for (u32 k = 0u; k <= row; ++k)
+    {
+        const i32 offset = (i32)k - (i32)(radius + 1u);
+        if (offset >= -(i32)radius && offset <= (i32)radius)
+        {
+            total += coefficient;
+
+            if (offset >= 0)
+                coefficients[offset] = coefficient;
+        }
+
+        coefficient = coefficient * (row - k) / (k + 1u);
+    }
+
+    Gaussian_Kernel kernel{};
+    kernel.m_weights[0] = (float)(coefficients[0] / total);
+    kernel.m_offsets[0] = 0.0f;
+    kernel.m_taps       = 1u;
+
+    // merge texel pairs (1, 2), (3, 4), ... into one fetch, an odd radius leaves the outermost texel on its own
+    for (u32 i = 1u; i <= radius; i += 2u)
+    {
+        const double w0 = coefficients[i];
+        const double w1 = i + 1u <= radius ? coefficients[i + 1u] : 0.0;
+
+        kernel.m_weights[kernel.m_taps] = (float)((w0 + w1) / total);
+        kernel.m_offsets[kernel.m_taps] = (float)((i * w0 + (i + 1u) * w1) / (w0 + w1));
+        ++kernel.m_taps;
+    }
+
+    return kernel;
+}
+
+// every radius is worked out at compile time, Blur bakes the one it uses into a gaussian.frag.glsl variant
+inline constexpr std::array<Gaussian_Kernel, Gaussian_Kernel::max_radius + 1u> gaussian_kernels = []
+{
+    std::array<Gaussian_Kernel, Gaussian_Kernel::max_radius + 1u> kernels{};
+    for (u32 radius = 0u; radius < kernels.size(); ++radius)
+        kernels[radius] = make_gaussian_kernel(radius);
+
+    return kernels;
+}();
+
+enum Blur_Mode : u8
+{
+    // separable gaussian, cost grows linearly with the radius
+    BLUR_GAUSSIAN = 0,
+
+    // dual filter (Bjorge, "Bandwidth-Efficient Rendering", SIGGRAPH 2015), downsample through a pyramid then upsample back
+    // every level halves the resolution so the cost stays nearly constant as the depth grows
+    BLUR_DUAL_FILTER,
+
+    BLUR_MAX,
+};
+
+class Blur
+{
+    struct Target
+    {
+        GLuint     m_fbo;
+        GLuint     m_texture;
+        glm::ivec2 m_size;
+    };
+
+    Blur_Mode           m_mode;
+    u32                 m_strength;
+    glm::ivec2          m_size;        // size of the texture being blurred
+    glm::ivec2          m_output_size; // the dual filter upsamples straight to this, the gaussian's output is composited bilinearly
+    GLuint              m_vao;
+    std::vector<Target> m_targets; // gaussian: two full size ping-pong targets, dual filter: full size output followed by each pyramid level
+
+    // specialized programs for the current mode, gaussian: horizontal and vertical pass, dual filter: downsample and upsample
+    Shaders*                     m_shaders;
+    std::array<Shader_Handle, 2> m_passes;
+
+    void   load_passes();
+    void   create_targets();
+    void   destroy_targets();
+    void   draw(GLuint src, const Target& dst);
+    GLuint apply_gaussian(GLuint texture);
+    GLuint apply_dual_filter(GLuint texture);
+
+public:
+    static constexpr u32 max_depth = 8u;
+
+    // strength is the radius in texels of the input for BLUR_GAUSSIAN and the pyramid depth for BLUR_DUAL_FILTER
+    Blur(Shaders& shaders, glm::ivec2 size, glm::ivec2 output_size, Blur_Mode mode, u32 strength);
+
+    void set_mode(Blur_Mode mode, u32 strength);
+
+    // returns the texture holding the blurred result, it stays valid until the next apply()
+    GLuint apply(GLuint texture);
+};
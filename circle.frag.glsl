@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec2  local;
+in float radius;
+in vec4  color;
+
+out vec4 out_col;
+
+void main()
+{
+    // signed distance to the edge of the circle, one pixel wide anti-aliased edge
+    float coverage = clamp(radius - length(local) + 0.5, 0.0, 1.0);
+
+    out_col = vec4(color.rgb, color.a * coverage);
+}
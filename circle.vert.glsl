@@ -0,0 +1,23 @@
+#version 330 core
+
+uniform mat4 u_projection;
+
+// one instance per circle
+layout(location = 0) in vec3 in_circle; // xy = center, z = radius
+layout(location = 1) in vec4 in_color;
+
+out vec2  local; // fragment position relative to the center
+out float radius;
+out vec4  color;
+
+void main()
+{
+    radius = in_circle.z;
+    color  = in_color;
+
+    // triangle strip corners, padded by a pixel for anti-aliasing
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+
+    local       = corner * (radius + 1.0);
+    gl_Position = u_projection * vec4(in_circle.xy + local, 0.0, 1.0);
+}
@@ -0,0 +1,49 @@
+#include "render.h"
+#include "circles.h"
+#include "circle_renderer.h"
+
+Circle_Renderer::Circle_Renderer() : m_batch(), m_instances(), m_batches() {}
+
+bool Circle_Renderer::init(const Shaders& shaders)
+{
+    constexpr std::array<Instance_Attribute, 2> attributes = {{
+        {0u, 3, GL_FLOAT, GL_FALSE, offsetof(Instance, m_pos)},
+        {1u, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Instance, m_color)},
+    }};
+
+    return m_batch.init(shaders, "circle", sizeof(Instance), attributes);
+}
+
+void Circle_Renderer::on_new_frame()
+{
+    m_instances.clear();
+    m_batches.clear();
+}
+
+void Circle_Renderer::add_circles(std::span<const Circle> circles)
+{
+    if (circles.empty())
+        return;
+
+    m_batches.push_back(Batch{circles, (u32)m_instances.size()});
+    m_instances.resize(m_instances.size() + circles.size());
+}
+
+void Circle_Renderer::build(u32 begin, u32 end)
+{
+    for_each_queued<Batch>(m_batches, begin, end, [&](const Batch& batch, u32 i)
+    {
+        const Circle& circle           = batch.m_items[i];
+        m_instances[batch.m_first + i] = Instance{circle.m_pos, circle.m_radius, circle.m_color};
+    });
+}
+
+void Circle_Renderer::draw(ImDrawList& dl)
+{
+    m_batch.draw(dl, m_instances.data(), (GLsizeiptr)(m_instances.size() * sizeof(Instance)), (GLsizei)m_instances.size());
+}
+
+u64 Circle_Renderer::hash() const
+{
+    return hash_span<Instance>(m_instances);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include <glm/glm.hpp>
+#include <imgui.h>
+
+#include "shaders.h"
+#include "hash.h"
+#include "instanced_batch.h"
+
+class Circle;
+
+// draws every circle in a single instanced draw call, 4 vertices per circle regardless of radius
+// the fragment shader shades each screen-aligned quad with the circle's signed distance
+class Circle_Renderer
+{
+    struct Instance
+    {
+        glm::vec2 m_pos;
+        float     m_radius;
+        ImU32     m_color;
+    };
+    static_assert(sizeof(Instance) == 16u, "circle.vert.glsl expects tightly packed 16 byte instances");
+
+    // circles queued this frame, their instances are written by build()
+    struct Batch
+    {
+        std::span<const Circle> m_items;
+        u32                     m_first; // index of its first instance
+    };
+
+    Instanced_Batch       m_batch;
+    std::vector<Instance> m_instances;
+    std::vector<Batch>    m_batches;
+
+public:
+    Circle_Renderer();
+
+    bool init(const Shaders& shaders);
+    void on_new_frame();
+
+    // only reserves the circles' instances, they have to stay where they are until build() has run
+    void add_circles(std::span<const Circle> circles);
+
+    // writes instances [begin, end), ranges that don't overlap can be built on different threads
+    void build(u32 begin, u32 end);
+    u32  queued() const { return (u32)m_instances.size(); }
+
+    // queue the batch onto a draw list, call once per frame after every circle has been added and built
+    void draw(ImDrawList& dl);
+
+    // hash of everything built this frame, lets the layer tell whether it has to be re-rendered
+    u64 hash() const;
+};
@@ -4,43 +4,44 @@
 #include "render.h"
 #include "rng.h"
 #include "circles.h"
+#include "profiler.h"
 
 #include <imgui_internal.h>
 
-glm::vec2 Circle::get_random_offscreen_point(Offscreen_Region region)
+glm::vec2 Circle::get_random_offscreen_point(Offscreen_Region region, const glm::vec2& min, const glm::vec2& max)
 {
-    const ImRect screen_area = {g_render->m_min, g_render->m_max};
+    const ImRect screen_area = {min, max};
 
     glm::vec2 offscreen{};
     switch (region)
     {
         case 0u:
         {
-            offscreen.x = g_rng.get_random(screen_area.Min.x - 100.0f, screen_area.Min.x - m_radius);
-            offscreen.y = g_rng.get_random(screen_area.Min.y, screen_area.Max.y);
+            offscreen.x = m_rng.get_random(screen_area.Min.x - 100.0f, screen_area.Min.x - m_radius);
+            offscreen.y = m_rng.get_random(screen_area.Min.y, screen_area.Max.y);
             break;
         }
 
         case 1u:
         {
-            offscreen.x = g_rng.get_random(screen_area.Max.x + m_radius, screen_area.Max.x + 100.0f);
-            offscreen.y = g_rng.get_random(screen_area.Min.y, screen_area.Max.y);
+            offscreen.x = m_rng.get_random(screen_area.Max.x + m_radius, screen_area.Max.x + 100.0f);
+            offscreen.y = m_rng.get_random(screen_area.Min.y, screen_area.Max.y);
             break;
         }
 
         // top
         case 2u:
         {
-            offscreen.x = g_rng.get_random(screen_area.Min.x, screen_area.Max.x);
-            offscreen.y = g_rng.get_random(screen_area.Max.y + m_radius, screen_area.Max.y + 100.0f);
+            offscreen.x = m_rng.get_random(screen_area.Min.x, screen_area.Max.x);
+            offscreen.y = m_rng.get_random(screen_area.Max.y + m_radius, screen_area.Max.y + 100.0f);
             break;
         }
 
         // bottom
         case 3u:
         {
-            offscreen.x = g_rng.get_random(screen_area.Min.x, screen_area.Max.x);
-            offscreen.y = g_rng.get_random(screen_area.Min.y - 100.0f, screen_area.Min.y - m_radius);
+            offscreen.x = m_rng.get_random(screen_area.Min.x, screen_area.Max.x);
+            offscreen.y = m_rng.get_random(screen_area.Min.y - 100.0f, screen_area.Min.y - m_radius);
             break;
         }
 
@@ -53,9 +54,9 @@ glm::vec2 Circle::get_random_offscreen_point(Offscreen_Region region)
 
 ImU32 Circle::get_random_color()
 {
-    const float h = g_rng.get_random(0.0f, 1.0f);
-    const float s = g_rng.get_random(0.5f, 1.0f);
-    const float v = g_rng.get_random(0.8f, 1.0f);
+    const float h = m_rng.get_random(0.0f, 1.0f);
+    const float s = m_rng.get_random(0.5f, 1.0f);
+    const float v = m_rng.get_random(0.8f, 1.0f);
 
     float r, g, b;
     ImGui::ColorConvertHSVtoRGB(h, s, v, r, g, b);
@@ -64,7 +65,7 @@ ImU32 Circle::get_random_color()
 }
 
 
-Circle::Circle() : m_path()
+Circle::Circle(u64 id, const glm::vec2& min, const glm::vec2& max) : m_rng(g_rng_seed, id), m_path(), m_path_index()
 {
     std::array<glm::vec2, 4u> control_points = 
     {
@@ -74,26 +75,22 @@ Circle::Circle() : m_path()
     m_color = get_random_color();
 
     // pick a random radius
-    m_radius = g_rng.get_random(13.0f, 35.0f);
+    m_radius = m_rng.get_random(13.0f, 35.0f);
 
     // pick a random speed
-    m_speed = g_rng.get_random(5.0f, 15.0f);
+    m_speed = m_rng.get_random(5.0f, 15.0f);
 
     // pick a random side of the screen area to start from
-    m_starting_region = (Offscreen_Region)g_rng.get_random<u32>(REGION_LEFT, REGION_BOTTOM);
+    m_starting_region = (Offscreen_Region)m_rng.get_random<u32>(REGION_LEFT, REGION_BOTTOM);
 
     // set our starting position to a random point offscreen
-    m_pos = get_random_offscreen_point(m_starting_region);
+    m_pos = get_random_offscreen_point(m_starting_region, min, max);
 
-    // get our destination region
-    do
-    {
-        m_ending_region = (Offscreen_Region) g_rng.get_random<u32>(REGION_LEFT, REGION_BOTTOM);
-    }
-    while (m_ending_region == m_starting_region);
+    // get our destination region, offset from the starting region so it's always a different side
+    m_ending_region = (Offscreen_Region)((m_starting_region + m_rng.get_random<u32>(1u, REGION_MAX - 1u)) % REGION_MAX);
 
     // get our destination point
-    const glm::vec2 dst = get_random_offscreen_point(m_ending_region);
+    const glm::vec2 dst = get_random_offscreen_point(m_ending_region, min, max);
 
     // start and end points
     control_points[0] = m_pos;
@@ -103,32 +100,31 @@ Circle::Circle() : m_path()
     control_points[1] = glm::vec2((m_pos.x + dst.x) * 0.5f, m_pos.y);
     control_points[2] = glm::vec2((m_pos.x + dst.x) * 0.5f, dst.y);
 
-    constexpr u32 num_nodes = 64u;
-    for (u32 i = 1; i <= num_nodes; ++i)
+    for (u32 i = 1; i <= path_nodes; ++i)
     {
-        const float t = float(i) / num_nodes;
+        const float t = float(i) / path_nodes;
 
-        m_path.push_back(ImBezierCubicCalc(control_points[0], control_points[1], control_points[2], control_points[3], t));
+        m_path[i - 1u] = ImBezierCubicCalc(control_points[0], control_points[1], control_points[2], control_points[3], t);
     }
 }
 
-void Circle::update()
+void Circle::update(float timestep)
 {
-    while (!m_path.empty() && glm::distance(m_pos, m_path.front()) < m_radius)
-        m_path.pop_front();
+    PROFILE_SCOPE("circle_update");
 
-    if (m_path.empty())
+    while (m_path_index < path_nodes && glm::distance(m_pos, m_path[m_path_index]) < m_radius)
+        ++m_path_index;
+
+    if (finished_path())
         return;
 
-    const glm::vec2 dir      = glm::normalize(m_path.front() - m_pos);
+    const glm::vec2 dir      = glm::normalize(m_path[m_path_index] - m_pos);
     const glm::vec2 velocity = dir * m_speed;
 
-    m_pos += velocity * ImGui::GetIO().DeltaTime;
-
-    g_render->get_dl("bg")->AddCircleFilled(m_pos, m_radius, m_color);
+    m_pos += velocity * timestep;
 }
 
 bool Circle::finished_path()
 {
-    return m_path.empty();
+    return m_path_index >= path_nodes;
 }
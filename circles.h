@@ -1,9 +1,11 @@
 #pragma once
 
-#include <deque>
+#include <array>
 
 #include <glm/glm.hpp>
 
+#include "rng.h"
+
 enum Offscreen_Region : u8
 {
     REGION_LEFT = 0,
@@ -16,20 +18,29 @@ enum Offscreen_Region : u8
 
 class Circle
 {
-    glm::vec2 get_random_offscreen_point(Offscreen_Region region);
+    glm::vec2 get_random_offscreen_point(Offscreen_Region region, const glm::vec2& min, const glm::vec2& max);
     ImU32     get_random_color();
 
+    // every random attribute is drawn from our own stream, keyed by our id
+    RNG m_rng;
+
 public:
-    Circle();
+    static constexpr u32 path_nodes = 64u;
+
+    // crosses the area between min and max, starting and ending just outside of it
+    Circle(u64 id, const glm::vec2& min, const glm::vec2& max);
 
     glm::vec2             m_pos;
     float                 m_radius;
     float                 m_speed;
     ImU32                 m_color;
-    std::deque<glm::vec2> m_path;
     Offscreen_Region      m_starting_region;
     Offscreen_Region      m_ending_region;
 
-    void update();
+    // points along our bezier, everything before m_path_index has been reached already
+    std::array<glm::vec2, path_nodes> m_path;
+    u32                               m_path_index;
+
+    void update(float timestep);
     bool finished_path();
 };
@@ -0,0 +1,47 @@
+#version 330 core
+
+// the upsample pass is compiled as its own variant with DUAL_FILTER_UPSAMPLE defined
+
+uniform sampler2D u_tex;
+
+in vec2 uv;
+
+out vec4 out_col;
+
+// 5 fetches, the center plus the 4 diagonals
+vec4 downsample(vec2 uv, vec2 half_texel)
+{
+    vec4 sum = texture(u_tex, uv) * 4.0;
+    sum     += texture(u_tex, uv - half_texel);
+    sum     += texture(u_tex, uv + half_texel);
+    sum     += texture(u_tex, uv + vec2(half_texel.x, -half_texel.y));
+    sum     += texture(u_tex, uv - vec2(half_texel.x, -half_texel.y));
+
+    return sum / 8.0;
+}
+
+// 8 fetches in a tent around the center, the diagonals count double
+vec4 upsample(vec2 uv, vec2 half_texel)
+{
+    vec4 sum = texture(u_tex, uv + vec2(-half_texel.x * 2.0, 0.0));
+    sum     += texture(u_tex, uv + vec2(-half_texel.x, half_texel.y)) * 2.0;
+    sum     += texture(u_tex, uv + vec2(0.0, half_texel.y * 2.0));
+    sum     += texture(u_tex, uv + vec2(half_texel.x, half_texel.y)) * 2.0;
+    sum     += texture(u_tex, uv + vec2(half_texel.x * 2.0, 0.0));
+    sum     += texture(u_tex, uv + vec2(half_texel.x, -half_texel.y)) * 2.0;
+    sum     += texture(u_tex, uv + vec2(0.0, -half_texel.y * 2.0));
+    sum     += texture(u_tex, uv + vec2(-half_texel.x, -half_texel.y)) * 2.0;
+
+    return sum / 12.0;
+}
+
+void main()
+{
+    vec2 half_texel = 0.5 / vec2(textureSize(u_tex, 0)); // half a texel of the source texture
+
+#ifdef DUAL_FILTER_UPSAMPLE
+    out_col = upsample(uv, half_texel);
+#else
+    out_col = downsample(uv, half_texel);
+#endif
+}
@@ -0,0 +1,12 @@
+#version 330 core
+
+out vec2 uv;
+
+void main()
+{
+    // fullscreen triangle, (0, 0) (2, 0) (0, 2) in uv space
+    vec2 pos = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+    uv          = pos;
+}
@@ -0,0 +1,138 @@
+#include <print>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+
+// windows 10 1803 and up, older sdks don't know about it
+#if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+#include <SDL3/SDL.h>
+
+#include "frame_limiter.h"
+
+// the scheduler rarely wakes us up sooner than this after the requested time, the margin adapts from here
+constexpr std::chrono::microseconds initial_spin_margin(1000);
+
+// a timer that overshoots by more than this is too coarse to pace with, spinning it away would burn a core every frame
+constexpr std::chrono::microseconds max_spin_margin(2000);
+
+Frame_Limiter::Frame_Limiter() :
+    m_mode(), m_period(), m_spin_margin(initial_spin_margin), m_timer(), m_timer_period(), m_deadline(), m_last_frame(), m_intervals(), m_jitter()
+{}
+
+Frame_Limiter::~Frame_Limiter()
+{
+#if defined(_WIN32)
+    if (m_timer != nullptr)
+        CloseHandle(m_timer);
+
+    if (m_timer_period)
+        timeEndPeriod(1);
+#endif
+}
+
+Pacing_Mode Frame_Limiter::init(Pacing_Mode mode, float target_fps)
+{
+    m_mode   = mode;
+    m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(target_fps, 1.0f)));
+
+    // not every driver can do late swap tearing
+    if (m_mode == PACING_ADAPTIVE_VSYNC && SDL_GL_SetSwapInterval(-1) != 0)
+    {
+        std::print("adaptive vsync isn't supported, falling back to vsync\n");
+        m_mode = PACING_VSYNC;
+    }
+
+    if (m_mode == PACING_VSYNC && SDL_GL_SetSwapInterval(1) != 0)
+    {
+        std::print("vsync isn't supported, pacing is off: {}\n", SDL_GetError());
+        m_mode = PACING_OFF;
+    }
+
+    if (m_mode == PACING_OFF || m_mode == PACING_SLEEP)
+        SDL_GL_SetSwapInterval(0);
+
+#if defined(_WIN32)
+    // sleeps are rounded up to the ~15.6ms system tick by default, most of a frame at 60fps
+    if (m_mode == PACING_SLEEP && m_timer == nullptr && !m_timer_period)
+    {
+        m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (m_timer == nullptr)
+            m_timer_period = timeBeginPeriod(1) == TIMERR_NOERROR;
+    }
+#endif
+
+    m_deadline   = Clock::now() + m_period;
+    m_last_frame = Clock::now();
+
+    return m_mode;
+}
+
+void Frame_Limiter::sleep_until(Clock::time_point wake)
+{
+#if defined(_WIN32)
+    if (m_timer != nullptr)
+    {
+        // relative due times are negative, in 100ns units
+        LARGE_INTEGER due{};
+        due.QuadPart = -std::chrono::duration_cast<std::chrono::duration<i64, std::ratio<1, 10'000'000>>>(wake - Clock::now()).count();
+
+        if (due.QuadPart < 0 && SetWaitableTimer(m_timer, &due, 0, nullptr, nullptr, FALSE))
+            WaitForSingleObject(m_timer, INFINITE);
+
+        return;
+    }
+#endif
+
+    std::this_thread::sleep_until(wake);
+}
+
+void Frame_Limiter::wait()
+{
+    if (m_mode == PACING_SLEEP)
+    {
+        // sleep is coarse and tends to overshoot, so it only covers the bulk of the wait
+        const Clock::time_point wake = m_deadline - m_spin_margin;
+        if (Clock::now() < wake)
+        {
+            sleep_until(wake);
+
+            // an overshoot eats into the spin, leave more room next time. capped so most of the wait is always slept
+            const Clock::duration overshoot = Clock::now() - wake;
+            const Clock::duration cap       = std::min<Clock::duration>(m_period / 4, max_spin_margin);
+            if (overshoot > m_spin_margin / 2)
+                m_spin_margin = std::min(overshoot * 2, cap);
+        }
+
+        // slowly hand the time back to sleep, every frame so late frames that skip the sleep can't pin the margin
+        m_spin_margin -= m_spin_margin / 64;
+
+        while (Clock::now() < m_deadline)
+            std::this_thread::yield();
+
+        // deadlines advance by exactly one period so errors don't accumulate, unless we've fallen a whole frame behind
+        m_deadline += m_period;
+        if (m_deadline < Clock::now())
+            m_deadline = Clock::now() + m_period;
+    }
+
+    const Clock::time_point now      = Clock::now();
+    const float             interval = std::chrono::duration<float, std::milli>(now - m_last_frame).count();
+    m_last_frame                     = now;
+
+    // the display's refresh isn't known with vsync, the average interval stands in for it
+    const float expected = m_mode == PACING_SLEEP ? std::chrono::duration<float, std::milli>(m_period).count() : m_intervals.mean();
+
+    m_jitter.push(m_intervals.empty() ? 0.0f : std::abs(interval - expected));
+    m_intervals.push(interval);
+}
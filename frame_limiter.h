@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+
+#include "stats.h"
+#include "types.h"
+
+enum Pacing_Mode : u8
+{
+    // render as fast as possible
+    PACING_OFF = 0,
+
+    // swap waits for the display's vertical blank
+    PACING_VSYNC,
+
+    // like vsync, but a late frame is swapped right away instead of waiting a whole extra refresh. falls back to vsync
+    PACING_ADAPTIVE_VSYNC,
+
+    // no vsync, sleep until shortly before the target frame time then spin the rest of the way for precision
+    PACING_SLEEP,
+
+    PACING_MAX,
+};
+
+// keeps the frame rate (and the cpu time we burn) down to what we actually want to show
+class Frame_Limiter
+{
+    using Clock = std::chrono::steady_clock;
+
+    Pacing_Mode       m_mode;
+    Clock::duration   m_period;       // target frame time for PACING_SLEEP
+    Clock::duration   m_spin_margin;  // we stop sleeping this long before the deadline, grows with the oversleep we observe
+    void*             m_timer;        // high resolution waitable timer, windows only
+    bool              m_timer_period; // raised the system timer resolution instead, windows before 10 1803
+    Clock::time_point m_deadline;
+    Clock::time_point m_last_frame;
+    Rolling_Stats     m_intervals; // ms between consecutive frames
+    Rolling_Stats     m_jitter;    // ms each interval was off from the expected one
+
+    void sleep_until(Clock::time_point wake);
+
+public:
+    Frame_Limiter();
+    ~Frame_Limiter();
+
+    Frame_Limiter(const Frame_Limiter&)            = delete;
+    Frame_Limiter& operator=(const Frame_Limiter&) = delete;
+
+    // needs the GL context to be current, returns the mode that was actually set up
+    Pacing_Mode init(Pacing_Mode mode, float target_fps);
+
+    // call once per frame right after the swap
+    void wait();
+
+    Pacing_Mode          mode() const { return m_mode; }
+    const Rolling_Stats& intervals() const { return m_intervals; }
+    const Rolling_Stats& jitter() const { return m_jitter; }
+};
@@ -1,14 +1,12 @@
 #version 330 core
 
-uniform mat4 u_projection;
-
-in vec2  in_pos;
-in vec2  in_uv;
-
 out vec2 uv;
 
 void main()
 {
-    gl_Position = u_projection * vec4(in_pos, 0, 1);
-    uv          = in_uv;
+    // fullscreen triangle, (0, 0) (2, 0) (0, 2) in uv space
+    vec2 pos = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+    uv          = pos;
 }
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+
+#include <glad/glad.h>
+
+#include "types.h"
+
+enum GL_Cap : u8
+{
+    GL_CAP_BLEND = 0,
+    GL_CAP_SCISSOR_TEST,
+
+    GL_CAP_MAX,
+};
+
+// shadow copy of the GL state our own passes touch, a bind that matches what's already bound never reaches the driver
+// nothing is ever read back with glGet*, anything that changes state behind our back (ImGui's backend, deleting bound
+// objects) has to be followed by invalidate() so the next call of each kind goes through
+class GL_State
+{
+    static constexpr GLuint unknown           = ~0u;
+    static constexpr u32    max_texture_units = 4u;
+
+    static constexpr std::array<GLenum, GL_CAP_MAX> cap_enums = {
+        GL_BLEND,
+        GL_SCISSOR_TEST,
+    };
+
+    GLuint                                m_program;
+    GLuint                                m_vertex_array;
+    GLuint                                m_array_buffer;
+    GLuint                                m_framebuffer;
+    GLuint                                m_active_texture; // index of the unit, not GL_TEXTUREi
+    std::array<GLuint, max_texture_units> m_textures;       // GL_TEXTURE_2D binding of each unit
+    std::array<GLuint, GL_CAP_MAX>        m_caps;           // GL_TRUE, GL_FALSE or unknown
+    std::array<GLint, 4>                  m_viewport;
+
+public:
+    GL_State() { invalidate(); }
+
+    void invalidate()
+    {
+        m_program        = unknown;
+        m_vertex_array   = unknown;
+        m_array_buffer   = unknown;
+        m_framebuffer    = unknown;
+        m_active_texture = unknown;
+
+        m_textures.fill(unknown);
+        m_caps.fill(unknown);
+        m_viewport.fill(-1);
+    }
+
+    void use_program(GLuint program)
+    {
+        if (m_program == program)
+            return;
+
+        glUseProgram(program);
+        m_program = program;
+    }
+
+    void bind_vertex_array(GLuint vertex_array)
+    {
+        if (m_vertex_array == vertex_array)
+            return;
+
+        glBindVertexArray(vertex_array);
+        m_vertex_array = vertex_array;
+    }
+
+    void bind_array_buffer(GLuint buffer)
+    {
+        if (m_array_buffer == buffer)
+            return;
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        m_array_buffer = buffer;
+    }
+
+    // binds both the read and draw framebuffer
+    void bind_framebuffer(GLuint framebuffer)
+    {
+        if (m_framebuffer == framebuffer)
+            return;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        m_framebuffer = framebuffer;
+    }
+
+    void bind_texture(GLuint texture, u32 unit = 0u)
+    {
+        if (m_textures[unit] == texture)
+            return;
+
+        if (m_active_texture != unit)
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            m_active_texture = unit;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, texture);
+        m_textures[unit] = texture;
+    }
+
+    void set_enabled(GL_Cap cap, bool enabled)
+    {
+        const GLuint state = enabled ? GL_TRUE : GL_FALSE;
+        if (m_caps[cap] == state)
+            return;
+
+        if (enabled)
+            glEnable(cap_enums[cap]);
+
+        else
+            glDisable(cap_enums[cap]);
+
+        m_caps[cap] = state;
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        const std::array<GLint, 4> viewport = {x, y, width, height};
+        if (m_viewport == viewport)
+            return;
+
+        glViewport(x, y, width, height);
+        m_viewport = viewport;
+    }
+};
+
+inline GL_State g_gl_state;
@@ -0,0 +1,189 @@
+#include <print>
+#include <format>
+#include <fstream>
+
+#include "render.h"
+#include "gpu_timers.h"
+#include "json.h"
+
+GPU_Timers::GPU_Timers() : m_names(), m_frames(), m_stats(), m_frame(), m_dropped(), m_enabled() {}
+
+void GPU_Timers::init(std::span<const std::string_view> names)
+{
+    m_names.assign(names.begin(), names.end());
+    m_stats.assign(names.size(), Rolling_Stats{});
+
+    for (auto& frame : m_frames)
+    {
+        frame.resize(names.size());
+        for (auto& query : frame)
+        {
+            glGenQueries((GLsizei)query.m_ids.size(), query.m_ids.data());
+            query.m_issued = false;
+        }
+    }
+
+    m_enabled = true;
+}
+
+void GPU_Timers::collect(u32 frame, bool wait)
+{
+    for (u32 pass = 0u; pass < m_frames[frame].size(); ++pass)
+    {
+        Query& query = m_frames[frame][pass];
+        if (!query.m_issued)
+            continue;
+
+        query.m_issued = false;
+
+        // the end timestamp lands after the begin one, if it's ready both are
+        if (!wait)
+        {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(query.m_ids[1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+            if (available == GL_FALSE)
+            {
+                ++m_dropped;
+                continue;
+            }
+        }
+
+        GLuint64 begin = 0u, end = 0u;
+        glGetQueryObjectui64v(query.m_ids[0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(query.m_ids[1], GL_QUERY_RESULT, &end);
+
+        m_stats[pass].push((float)((double)(end - begin) / 1e6));
+    }
+}
+
+void GPU_Timers::on_new_frame()
+{
+    if (!m_enabled)
+        return;
+
+    // the slot we're about to record into was issued latency frames ago, its results are read before being overwritten
+    m_frame = (m_frame + 1u) % latency;
+    collect(m_frame, false);
+}
+
+void GPU_Timers::begin(u32 pass)
+{
+    if (m_enabled)
+        glQueryCounter(m_frames[m_frame][pass].m_ids[0], GL_TIMESTAMP);
+}
+
+void GPU_Timers::end(u32 pass)
+{
+    if (!m_enabled)
+        return;
+
+    glQueryCounter(m_frames[m_frame][pass].m_ids[1], GL_TIMESTAMP);
+    m_frames[m_frame][pass].m_issued = true;
+}
+
+void GPU_Timers::flush()
+{
+    if (!m_enabled)
+        return;
+
+    // oldest first so the rolling stats keep frame order, the current slot was recorded last
+    for (u32 i = 1u; i <= latency; ++i)
+        collect((m_frame + i) % latency, true);
+}
+
+void GPU_Timers::draw_overlay() const
+{
+    if (!m_enabled)
+        return;
+
+    ImGui::SetNextWindowBgAlpha(0.5f);
+
+    constexpr ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+                                       ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoInputs;
+
+    if (ImGui::Begin("GPU timers", nullptr, flags))
+    {
+        ImGui::TextUnformatted("gpu ms       avg    p95    max");
+
+        // passes that never ran (e.g. a layer that's always cached) have nothing to show
+        for (u32 pass = 0u; pass < m_stats.size(); ++pass)
+        {
+            const Rolling_Stats& stats = m_stats[pass];
+            if (stats.empty())
+                continue;
+
+            // ImGui formats into its own buffer, the overlay doesn't allocate every frame
+            const std::string_view name = m_names[pass];
+            ImGui::Text("%-10.*s %6.3f %6.3f %6.3f", (i32)name.size(), name.data(), stats.mean(), stats.percentile(0.95f), stats.max());
+        }
+
+        if (m_dropped > 0u)
+            ImGui::Text("dropped: %llu", (unsigned long long)m_dropped);
+    }
+
+    ImGui::End();
+}
+
+void GPU_Timers::print() const
+{
+    if (!m_enabled)
+        return;
+
+    for (u32 pass = 0u; pass < m_stats.size(); ++pass)
+    {
+        const Rolling_Stats& stats = m_stats[pass];
+        if (stats.empty())
+            continue;
+
+        std::print(
+            "gpu {} ms min: {:.3f} average: {:.3f} p50: {:.3f} p95: {:.3f} max: {:.3f}\n",
+            m_names[pass],
+            stats.min(),
+            stats.mean(),
+            stats.percentile(0.50f),
+            stats.percentile(0.95f),
+            stats.max()
+        );
+    }
+}
+
+bool GPU_Timers::dump(const std::filesystem::path& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        std::print("failed to open {} for the gpu timings\n", path.string());
+        return false;
+    }
+
+    // a broken context can give us null
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    if (!renderer)
+        renderer = "unknown";
+
+    std::string json = std::format("{{\n  \"renderer\": \"{}\",\n  \"dropped\": {},\n  \"passes\": {{", json_escape(renderer), m_dropped);
+
+    // every pass is listed so consumers don't have to special case missing keys, count is 0 for passes that never ran
+    for (u32 pass = 0u; pass < m_stats.size(); ++pass)
+    {
+        const Rolling_Stats& stats = m_stats[pass];
+
+        json += std::format(
+            "{}\n    \"{}\": {{ \"count\": {}, \"min_ms\": {:.4f}, \"mean_ms\": {:.4f}, \"p50_ms\": {:.4f}, \"p95_ms\": {:.4f}, \"max_ms\": {:.4f} }}",
+            pass == 0u ? "" : ",",
+            m_names[pass],
+            stats.count(),
+            stats.min(),
+            stats.mean(),
+            stats.percentile(0.50f),
+            stats.percentile(0.95f),
+            stats.max()
+        );
+    }
+
+    json += "\n  }\n}\n";
+    file << json;
+
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string_view>
+#include <span>
+#include <filesystem>
+
+#include <glad/glad.h>
+
+#include "stats.h"
+#include "types.h"
+
+// gpu time spent in each pass, measured with a pair of GL_TIMESTAMP queries around it
+// unlike GL_TIME_ELAPSED timestamps can nest, so a pass may contain others (e.g. the whole frame)
+// results are read back several frames later and only if they're ready, the pipeline is never stalled on a query
+class GPU_Timers
+{
+    static constexpr u32 latency = 4u; // frames a query has to finish before its slot is reused
+
+    struct Query
+    {
+        std::array<GLuint, 2u> m_ids; // begin and end timestamp
+        bool                   m_issued;
+    };
+
+    std::vector<std::string_view>           m_names;
+    std::array<std::vector<Query>, latency> m_frames; // [frame slot][pass]
+    std::vector<Rolling_Stats>              m_stats;  // milliseconds, per pass
+    u32                                     m_frame;  // slot being recorded
+    u64                                     m_dropped; // results that still weren't ready when their slot came around
+    bool                                    m_enabled;
+
+    void collect(u32 frame, bool wait);
+
+public:
+    GPU_Timers();
+
+    // needs a current GL context, the timers stay disabled (and free) if this is never called
+    void init(std::span<const std::string_view> names);
+
+    bool enabled() const { return m_enabled; }
+
+    void on_new_frame();
+    void begin(u32 pass);
+    void end(u32 pass);
+
+    // blocks until every issued query has a result, only meant for shutdown
+    void flush();
+
+    u32                  passes() const { return (u32)m_stats.size(); }
+    std::string_view     name(u32 pass) const { return m_names[pass]; }
+    const Rolling_Stats& stats(u32 pass) const { return m_stats[pass]; }
+
+    void draw_overlay() const;
+    void print() const;
+    bool dump(const std::filesystem::path& path) const;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstring>
+#include <span>
+
+#include "types.h"
+
+// FNV-1a, fed a word at a time instead of a byte at a time since we only use it to spot changes in large buffers
+constexpr u64 fnv1a_basis = 0xCBF29CE484222325ull;
+constexpr u64 fnv1a_prime = 0x100000001B3ull;
+
+inline u64 hash_bytes(const void* data, size_t size, u64 hash = fnv1a_basis)
+{
+    auto bytes = (const u8*)data;
+
+    for (; size >= sizeof(u64); size -= sizeof(u64), bytes += sizeof(u64))
+    {
+        u64 word;
+        std::memcpy(&word, bytes, sizeof(u64));
+
+        hash = (hash ^ word) * fnv1a_prime;
+    }
+
+    for (; size > 0u; --size, ++bytes)
+        hash = (hash ^ *bytes) * fnv1a_prime;
+
+    return hash;
+}
+
+template <typename T>
+u64 hash_span(std::span<const T> span, u64 hash = fnv1a_basis)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable types can be hashed by their bytes");
+    return hash_bytes(span.data(), span.size_bytes(), hash);
+}
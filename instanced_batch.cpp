@@ -0,0 +1,73 @@
+#include <algorithm>
+
+#include "render.h"
+#include "gl_state.h"
+#include "instanced_batch.h"
+
+Instanced_Batch::Instanced_Batch() : m_vao(), m_vbo(), m_capacity(), m_shaders(), m_shader(), m_data(), m_size(), m_instances() {}
+
+bool Instanced_Batch::init(const Shaders& shaders, std::string_view shader, GLsizei stride, std::span<const Instance_Attribute> attributes)
+{
+    m_shaders = &shaders;
+    m_shader  = shaders.find(shader);
+    if (!m_shader.valid())
+        return false;
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+
+    g_gl_state.bind_vertex_array(m_vao);
+    g_gl_state.bind_array_buffer(m_vbo);
+
+    // every attribute advances once per instance, the quad corners come from gl_VertexID
+    for (const auto& attribute : attributes)
+    {
+        glEnableVertexAttribArray(attribute.m_index);
+        glVertexAttribPointer(attribute.m_index, attribute.m_size, attribute.m_type, attribute.m_normalized, stride, (void*)attribute.m_offset);
+        glVertexAttribDivisor(attribute.m_index, 1);
+    }
+
+    return true;
+}
+
+void Instanced_Batch::draw(ImDrawList& dl, const void* data, GLsizeiptr size, GLsizei instances)
+{
+    if (instances <= 0)
+        return;
+
+    m_data      = data;
+    m_size      = size;
+    m_instances = instances;
+
+    dl.AddCallback(draw_callback, this);
+    dl.AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+void Instanced_Batch::draw_callback(const ImDrawList* dl, const ImDrawCmd* cmd)
+{
+    auto batch = (Instanced_Batch*)cmd->UserCallbackData;
+
+    // same projection ImGui uses for the layer
+    const ImGuiViewport* viewport = ImGui::GetMainViewport();
+    const auto ortho = glm::ortho(viewport->Pos.x, viewport->Pos.x + viewport->Size.x, viewport->Pos.y + viewport->Size.y, viewport->Pos.y);
+
+    // ImGui's backend just set up its own state behind the cache's back
+    g_gl_state.invalidate();
+    g_gl_state.bind_array_buffer(batch->m_vbo);
+
+    // orphan last frame's storage, the driver hands us fresh memory instead of waiting for the gpu to finish reading the old one
+    batch->m_capacity = std::max(batch->m_capacity, batch->m_size);
+    glBufferData(GL_ARRAY_BUFFER, batch->m_capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, batch->m_size, batch->m_data);
+
+    const Shader& shader = batch->m_shaders->get(batch->m_shader);
+
+    g_gl_state.use_program(shader.m_shader_program);
+    glUniformMatrix4fv(shader.location(UNIFORM_PROJECTION), 1, GL_FALSE, &ortho[0][0]);
+
+    // the layer is cleared to fullscreen anyway, ImGui re-enables scissoring when it resets its render state
+    g_gl_state.set_enabled(GL_CAP_SCISSOR_TEST, false);
+
+    g_gl_state.bind_vertex_array(batch->m_vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, batch->m_instances);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <span>
+#include <algorithm>
+#include <string_view>
+
+#include <glad/glad.h>
+#include <imgui.h>
+
+#include "shaders.h"
+#include "types.h"
+
+// one per-instance vertex attribute, offset is from the start of the instance and can reach into the next one
+struct Instance_Attribute
+{
+    GLuint    m_index;
+    GLint     m_size;
+    GLenum    m_type;
+    GLboolean m_normalized;
+    size_t    m_offset;
+};
+
+// the gpu side of the instanced renderers: a vao/vbo pair the frame's instances are streamed into, drawn as a 4 vertex
+// triangle strip per instance from an ImDrawList callback in the layer's projection
+class Instanced_Batch
+{
+    GLuint     m_vao;
+    GLuint     m_vbo;
+    GLsizeiptr m_capacity; // bytes
+
+    const Shaders* m_shaders;
+    Shader_Handle  m_shader;
+
+    // what the callback draws, set when it's queued
+    const void* m_data;
+    GLsizeiptr  m_size;
+    GLsizei     m_instances;
+
+    static void draw_callback(const ImDrawList* dl, const ImDrawCmd* cmd);
+
+public:
+    Instanced_Batch();
+
+    bool init(const Shaders& shaders, std::string_view shader, GLsizei stride, std::span<const Instance_Attribute> attributes);
+
+    // queues uploading size bytes of data and drawing instances onto dl, data has to stay put until the list is rendered
+    void draw(ImDrawList& dl, const void* data, GLsizeiptr size, GLsizei instances);
+};
+
+// calls fn(batch, index) for the items [begin, end), counted across every batch in the order they were queued. a batch
+// has its items in m_items, ranges that don't overlap can be walked on different threads
+template <typename Batch, typename Fn>
+void for_each_queued(std::span<const Batch> batches, u32 begin, u32 end, Fn&& fn)
+{
+    u32 offset = 0u; // first item of the batch
+    for (const auto& batch : batches)
+    {
+        const u32 size  = (u32)batch.m_items.size();
+        const u32 first = std::max(begin, offset);
+        const u32 last  = std::min(end, offset + size);
+
+        for (u32 i = first; i < last; ++i)
+            fn(batch, i - offset);
+
+        offset += size;
+        if (offset >= end)
+            return;
+    }
+}
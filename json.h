@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// for putting text we didn't write (cpu, gpu and commit names) inside a json string
+inline std::string json_escape(std::string_view text)
+{
+    std::string escaped{};
+    escaped.reserve(text.size());
+
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+
+        // control characters can't appear raw in a json string, none of ours need keeping
+        if ((unsigned char)c >= 0x20u)
+            escaped += c;
+    }
+
+    return escaped;
+}
@@ -1,11 +1,145 @@
+#include <print>
+#include <charconv>
+#include <algorithm>
+
 #include "render.h"
+#include "rng.h"
 
 // todo: particle system heavily blurred in the background
 
-int main()
+template <typename T>
+bool parse_number(const char* str, T& out)
+{
+    const std::string_view view = str;
+    return std::from_chars(view.data(), view.data() + view.size(), out).ec == std::errc();
+}
+
+int main(int argc, char** argv)
 {
-    g_render = std::make_shared<Render>();
+    Render_Settings settings{};
+    bool            pacing_set = false;
+
+    // --headless [frames]: render offscreen and print frame timings
+    // --seed <seed>: fix the rng seed so runs are reproducible
+    // --blur <gaussian|dual_filter> [strength]: background blur mode, radius for gaussian or pyramid depth for dual_filter
+    // --bg-scale <scale>: resolution of the background layer relative to the display, e.g. 0.5 or 0.25
+    // --pacing <off|vsync|adaptive|sleep>: how frames are paced, vsync by default and off when headless
+    // --fps <target>: frame rate to pace to, implies --pacing sleep unless a mode was given
+    // --frame-times <json path>: write frame time percentiles and a histogram of every frame at exit
+    // --alloc-check: after a short warm-up any heap allocation during a frame is reported, and asserts in debug builds
+    // --trace <json path>: write a chrome trace of the profiling zones at exit, needs a build with ROPE_DEMO_PROFILE
+    // --gpu-timers [json path]: time each render pass on the gpu, show the results in an overlay and optionally write them out at exit
+    // --perf-counters: count cycles, instructions and cache/branch misses per simulation stage (linux only), printed at exit
+    // --overlay: show the performance overlay (F1) from the start
+    // --iterations <n>, --substeps <n>, --threads <n>: starting values of the rope's solver knobs, also tunable in the overlay
+    // --ropes <n>, --nodes <n>: starting size of the scene, nodes is per rope, also tunable in the overlay
+    for (i32 i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--headless")
+        {
+            settings.headless = true;
+
+            if (i + 1 < argc && parse_number(argv[i + 1], settings.headless_frames))
+                ++i;
+        }
+
+        else if (arg == "--seed" && i + 1 < argc)
+            parse_number(argv[++i], g_rng_seed);
+
+        else if (arg == "--blur" && i + 1 < argc)
+        {
+            const std::string_view mode = argv[++i];
+            settings.bg_blur            = mode == "dual_filter" ? BLUR_DUAL_FILTER : BLUR_GAUSSIAN;
+
+            // the dual filter's strength is a pyramid depth, the default radius would be far too deep
+            settings.bg_blur_strength = settings.bg_blur == BLUR_DUAL_FILTER ? 3u : 4u;
+
+            if (i + 1 < argc && parse_number(argv[i + 1], settings.bg_blur_strength))
+                ++i;
+        }
+
+        else if (arg == "--bg-scale" && i + 1 < argc)
+        {
+            parse_number(argv[++i], settings.bg_scale);
+            settings.bg_scale = std::clamp(settings.bg_scale, 0.05f, 1.0f);
+        }
+
+        else if (arg == "--pacing" && i + 1 < argc)
+        {
+            constexpr std::array<std::string_view, PACING_MAX> modes = {"off", "vsync", "adaptive", "sleep"};
+
+            // an unknown mode leaves the default alone, including what --fps and --headless pick
+            const auto mode = std::find(modes.begin(), modes.end(), std::string_view(argv[++i]));
+            if (mode == modes.end())
+                std::print("unknown --pacing mode {}, expected off, vsync, adaptive or sleep\n", argv[i]);
+            else
+            {
+                settings.pacing = (Pacing_Mode)(mode - modes.begin());
+                pacing_set      = true;
+            }
+        }
+
+        else if (arg == "--fps" && i + 1 < argc)
+        {
+            parse_number(argv[++i], settings.target_fps);
+
+            if (!pacing_set)
+                settings.pacing = PACING_SLEEP;
+        }
+
+        else if (arg == "--frame-times" && i + 1 < argc)
+            settings.frame_times_dump = argv[++i];
+
+        else if (arg == "--alloc-check")
+            settings.alloc_check = true;
+
+        else if (arg == "--trace" && i + 1 < argc)
+        {
+            settings.trace_dump = argv[++i];
+
+#if !defined(ROPE_DEMO_PROFILE)
+            std::print("--trace needs a build with ROPE_DEMO_PROFILE defined, the trace will be empty\n");
+#endif
+        }
+
+        else if (arg == "--gpu-timers")
+        {
+            settings.gpu_timers = true;
+
+            if (i + 1 < argc && !std::string_view(argv[i + 1]).starts_with("--"))
+                settings.gpu_timers_dump = argv[++i];
+        }
+
+        else if (arg == "--perf-counters")
+            settings.perf_counters = true;
+
+        else if (arg == "--overlay")
+            settings.overlay = true;
+
+        else if (arg == "--iterations" && i + 1 < argc)
+            parse_number(argv[++i], settings.rope.iterations);
+
+        else if (arg == "--substeps" && i + 1 < argc)
+            parse_number(argv[++i], settings.rope.substeps);
+
+        else if (arg == "--threads" && i + 1 < argc)
+            parse_number(argv[++i], settings.rope.threads);
+
+        else if (arg == "--ropes" && i + 1 < argc)
+            parse_number(argv[++i], settings.rope.ropes);
+
+        else if (arg == "--nodes" && i + 1 < argc)
+            parse_number(argv[++i], settings.rope.nodes);
+    }
+
+    // benchmarks want every frame they can get unless asked otherwise
+    if (settings.headless && !pacing_set && settings.pacing != PACING_SLEEP)
+        settings.pacing = PACING_OFF;
+
+    g_render = std::make_shared<Render>(settings);
     g_render->run();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,249 @@
+#include <print>
+#include <string>
+#include <format>
+
+#include "perf_counters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+constexpr std::array<const char*, PERF_STAGE_MAX> stage_names = {
+    "spawn",
+    "circles",
+    "nodes",
+    "node_collide",
+    "node_simulate",
+    "node_constrain",
+};
+
+#if defined(__linux__)
+
+struct Perf_Event_Config
+{
+    u32 m_type;
+    u64 m_config;
+};
+
+constexpr std::array<Perf_Event_Config, PERF_COUNTER_MAX> event_configs = {{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8u) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+}};
+
+static i32 open_event(const Perf_Event_Config& config, i32 group_fd)
+{
+    perf_event_attr attr{};
+    attr.size           = sizeof(attr);
+    attr.type           = config.m_type;
+    attr.config         = config.m_config;
+    attr.disabled       = group_fd == -1; // the leader starts the whole group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // this thread, any cpu
+    return (i32)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0ul);
+}
+
+#endif
+
+// each thread finds its group without the lock after opening it
+thread_local Perf_Thread_Group* t_perf_group = nullptr;
+
+Perf_Thread_Group& Perf_Counters::thread_group()
+{
+    if (t_perf_group != nullptr)
+        return *t_perf_group;
+
+    auto group = std::make_unique<Perf_Thread_Group>();
+    group->m_fds.fill(-1);
+    group->m_slots.fill(-1);
+
+#if defined(__linux__)
+    // cycles leads the group, the rest are left out if the pmu doesn't have them. a thread whose leader fails keeps its
+    // empty group so it doesn't retry the syscalls on every read
+    for (u32 counter = 0u; counter < PERF_COUNTER_MAX; ++counter)
+    {
+        group->m_fds[counter] = open_event(event_configs[counter], counter == PERF_CYCLES ? -1 : group->m_fds[PERF_CYCLES]);
+        if (group->m_fds[counter] < 0)
+        {
+            if (counter == PERF_CYCLES)
+                break;
+
+            continue;
+        }
+
+        group->m_slots[counter] = (i32)group->m_opened++;
+    }
+
+    if (group->counting())
+    {
+        ioctl(group->m_fds[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(group->m_fds[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+
+    std::scoped_lock lock(m_mutex);
+
+    m_groups.push_back(std::move(group));
+    t_perf_group = m_groups.back().get();
+
+    return *t_perf_group;
+}
+
+bool Perf_Counters::init()
+{
+#if defined(__linux__)
+    m_enabled = thread_group().counting();
+
+    if (!m_enabled)
+        std::print("couldn't open hardware performance counters, check /proc/sys/kernel/perf_event_paranoid\n");
+#else
+    std::print("hardware performance counters are only available on linux\n");
+#endif
+
+    return m_enabled;
+}
+
+Perf_Reading Perf_Counters::read()
+{
+    Perf_Reading reading{};
+
+#if defined(__linux__)
+    const Perf_Thread_Group& group = thread_group();
+    if (!group.counting())
+        return reading;
+
+    // the number of counters, time enabled, time running, then each value in the order they joined the group
+    std::array<u64, 3u + PERF_COUNTER_MAX> buffer{};
+    if (::read(group.m_fds[PERF_CYCLES], buffer.data(), sizeof(buffer)) <= 0)
+        return reading;
+
+    reading.m_time_enabled = buffer[1];
+    reading.m_time_running = buffer[2];
+
+    for (u32 counter = 0u; counter < PERF_COUNTER_MAX; ++counter)
+    {
+        if (group.m_slots[counter] >= 0)
+            reading.m_values[counter] = buffer[3u + group.m_slots[counter]];
+    }
+#endif
+
+    return reading;
+}
+
+void Perf_Counters::add(Perf_Stage stage, const Perf_Reading& begin, const Perf_Reading& end, u64 work)
+{
+    Perf_Thread_Group& group = thread_group();
+    if (!group.counting())
+        return;
+
+    const u64 enabled = end.m_time_enabled - begin.m_time_enabled;
+    const u64 running = end.m_time_running - begin.m_time_running;
+
+    group.m_time_enabled[stage] += enabled;
+    group.m_time_running[stage] += running;
+
+    group.m_work[stage] += work;
+
+    // nothing was counted at all, the per-item figures only cover work done while something was
+    if (running == 0u)
+        return;
+
+    group.m_counted_work[stage] += work;
+
+    const double scale = (double)enabled / running;
+    for (u32 counter = 0u; counter < PERF_COUNTER_MAX; ++counter)
+        group.m_totals[stage][counter] += (u64)((end.m_values[counter] - begin.m_values[counter]) * scale + 0.5);
+}
+
+void Perf_Counters::print()
+{
+    if (!m_enabled)
+        return;
+
+    std::scoped_lock lock(m_mutex);
+
+    for (u32 stage = 0u; stage < PERF_STAGE_MAX; ++stage)
+    {
+        Perf_Values totals{};
+        u64         work         = 0u;
+        u64         counted_work = 0u;
+        u64         enabled      = 0u;
+        u64         running      = 0u;
+
+        // a counter only makes sense if every thread that ran the stage could count it
+        std::array<bool, PERF_COUNTER_MAX> available{};
+        available.fill(true);
+
+        for (auto& group : m_groups)
+        {
+            if (group->m_work[stage] == 0u)
+                continue;
+
+            for (u32 counter = 0u; counter < PERF_COUNTER_MAX; ++counter)
+            {
+                totals[counter]    += group->m_totals[stage][counter];
+                available[counter]  = available[counter] && group->m_slots[counter] >= 0;
+            }
+
+            work         += group->m_work[stage];
+            counted_work += group->m_counted_work[stage];
+            enabled      += group->m_time_enabled[stage];
+            running      += group->m_time_running[stage];
+        }
+
+        if (work == 0u)
+            continue;
+
+        // the pmu never had room for the group while this stage ran
+        if (running == 0u || counted_work == 0u)
+            available.fill(false);
+
+        auto per_item = [&](Perf_Counter counter) -> std::string
+        {
+            return available[counter] ? std::format("{:.3f}", (double)totals[counter] / counted_work) : "n/a";
+        };
+
+        // multiplexed, the counts are extrapolated from the time the group actually ran
+        const std::string scaled = running > 0u && running < enabled
+                                     ? std::format(", scaled from {:.1f}% of the time", running * 100.0 / enabled)
+                                     : "";
+
+        const std::string ipc = available[PERF_INSTRUCTIONS] && totals[PERF_CYCLES] > 0u
+                                  ? std::format("{:.2f}", (double)totals[PERF_INSTRUCTIONS] / totals[PERF_CYCLES])
+                                  : "n/a";
+
+        std::print(
+            "perf {}: ipc: {} per item cycles: {} l1d misses: {} llc misses: {} branch misses: {} ({} items{})\n",
+            stage_names[stage],
+            ipc,
+            per_item(PERF_CYCLES),
+            per_item(PERF_L1D_MISSES),
+            per_item(PERF_LLC_MISSES),
+            per_item(PERF_BRANCH_MISSES),
+            work,
+            scaled
+        );
+    }
+}
+
+void Perf_Counters::reset()
+{
+    std::scoped_lock lock(m_mutex);
+
+    for (auto& group : m_groups)
+    {
+        group->m_totals       = {};
+        group->m_work         = {};
+        group->m_counted_work = {};
+        group->m_time_enabled = {};
+        group->m_time_running = {};
+    }
+}
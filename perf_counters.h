@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "types.h"
+
+// parts of the simulation the hardware counters are attributed to
+enum Perf_Stage : u8
+{
+    PERF_STAGE_SPAWN = 0,
+    PERF_STAGE_CIRCLES,
+    PERF_STAGE_NODES, // collide, integrate and constrain, the demo runs them fused per node
+
+    // the node kernels on their own, only rope_bench's fixtures count these
+    PERF_STAGE_NODE_COLLIDE,
+    PERF_STAGE_NODE_SIMULATE,
+    PERF_STAGE_NODE_CONSTRAIN,
+
+    PERF_STAGE_MAX,
+};
+
+enum Perf_Counter : u8
+{
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES, // l1 data cache read misses
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+
+    PERF_COUNTER_MAX,
+};
+
+using Perf_Values = std::array<u64, PERF_COUNTER_MAX>;
+
+// a group is only counting while the pmu has room for all of it, when other users (e.g. the nmi watchdog) hold counters
+// the kernel multiplexes it and running falls behind enabled
+struct Perf_Reading
+{
+    Perf_Values m_values;
+    u64         m_time_enabled; // ns
+    u64         m_time_running; // ns
+};
+
+// counters opened by a single thread, only that thread reads them or adds to its totals
+struct Perf_Thread_Group
+{
+    std::array<i32, PERF_COUNTER_MAX> m_fds;   // -1 if the counter couldn't be opened, without cycles nothing is
+    std::array<i32, PERF_COUNTER_MAX> m_slots; // where each counter is in a group read
+    u32                               m_opened;
+
+    std::array<Perf_Values, PERF_STAGE_MAX> m_totals;       // scaled up to the whole time enabled
+    std::array<u64, PERF_STAGE_MAX>         m_work;         // items (nodes, circles) processed by each stage
+    std::array<u64, PERF_STAGE_MAX>         m_counted_work; // the part of m_work done while the group ran at least some of the time
+    std::array<u64, PERF_STAGE_MAX>         m_time_enabled; // ns
+    std::array<u64, PERF_STAGE_MAX>         m_time_running; // ns
+
+    bool counting() const { return m_fds[PERF_CYCLES] >= 0; }
+};
+
+// hardware performance counters through perf_event_open, linux only. every thread that enters a Perf_Scope opens its own
+// counter group (user space only, counting just that thread) the first time, stage totals are kept per thread and summed
+// when printing. counters the cpu or hypervisor doesn't expose are reported as n/a, without cycles nothing is counted
+class Perf_Counters
+{
+    bool                                            m_enabled;
+    std::mutex                                      m_mutex; // only taken when a thread opens its group and when printing
+    std::vector<std::unique_ptr<Perf_Thread_Group>> m_groups;
+
+    Perf_Thread_Group& thread_group();
+
+public:
+    Perf_Counters() : m_enabled(), m_mutex(), m_groups() {}
+
+    // tries opening a group on the calling thread, fails without a pmu or if perf_event_paranoid doesn't allow it
+    bool init();
+    bool enabled() const { return m_enabled; }
+
+    // the calling thread's counters right now
+    Perf_Reading read();
+
+    // counts from intervals the group was multiplexed over are scaled up to the whole interval, ones it never ran in are
+    // dropped
+    void add(Perf_Stage stage, const Perf_Reading& begin, const Perf_Reading& end, u64 work);
+
+    // ipc and per-item cycles/misses of every stage, flagged when they were scaled and n/a if the group never ran
+    void print();
+
+    // clears every stage's totals, only while no Perf_Scope is open
+    void reset();
+};
+
+inline Perf_Counters g_perf_counters;
+
+// counts the rest of the enclosing scope towards a stage, costs a branch when the counters aren't enabled
+class Perf_Scope
+{
+    Perf_Stage   m_stage;
+    u64          m_work;
+    Perf_Reading m_begin;
+
+public:
+    Perf_Scope(Perf_Stage stage, u64 work) : m_stage(stage), m_work(work), m_begin()
+    {
+        if (g_perf_counters.enabled())
+            m_begin = g_perf_counters.read();
+    }
+
+    ~Perf_Scope()
+    {
+        if (g_perf_counters.enabled())
+            g_perf_counters.add(m_stage, m_begin, g_perf_counters.read(), m_work);
+    }
+
+    Perf_Scope(const Perf_Scope&)            = delete;
+    Perf_Scope& operator=(const Perf_Scope&) = delete;
+};
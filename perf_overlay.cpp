@@ -0,0 +1,113 @@
+#include <format>
+#include <cfloat>
+#include <type_traits>
+
+#include "render.h"
+#include "perf_overlay.h"
+#include "thread_pool.h"
+
+Perf_Overlay::Perf_Overlay(bool visible) :
+    m_stage_ms(), m_wall_ms(), m_nodes(), m_circles(), m_candidate_pairs(), m_contacts(), m_iterations(), m_residual(), m_allocs(), m_visible(visible)
+{}
+
+void Perf_Overlay::push(const Rope_Stats& stats, const Alloc_Stats& frame_allocs)
+{
+    for (u32 stage = 0u; stage < SIM_STAGE_MAX; ++stage)
+        m_stage_ms[stage].push(stats.m_stage_ms[stage]);
+
+    m_wall_ms.push(stats.m_wall_ms);
+
+    m_nodes.push((float)stats.m_nodes);
+    m_circles.push((float)stats.m_circles);
+    m_candidate_pairs.push((float)stats.m_candidate_pairs);
+    m_contacts.push((float)stats.m_contacts);
+    m_iterations.push((float)stats.m_iterations);
+    m_residual.push(stats.m_residual);
+    m_allocs.push((float)frame_allocs.m_count);
+}
+
+// a graph of every sample the stats hold, oldest on the left, with the latest value and average written over it
+static void plot(std::string_view label, const Rolling_Stats& stats, std::string_view unit = {})
+{
+    // formatted in place so drawing the panel doesn't allocate
+    std::array<char, 96> overlay{};
+    std::format_to_n(overlay.data(), overlay.size() - 1u, "{} {:.3f}{} avg {:.3f}", label, stats.latest(), unit, stats.mean());
+
+    auto sample = [](void* data, i32 i) { return ((const Rolling_Stats*)data)->at((u32)i); };
+
+    ImGui::PushID(label.data(), label.data() + label.size());
+    ImGui::PlotLines("##plot", sample, (void*)&stats, (i32)stats.count(), 0, overlay.data(), 0.0f, FLT_MAX, ImVec2(-FLT_MIN, 40.0f));
+    ImGui::PopID();
+}
+
+template <typename T>
+static bool slider(const char* label, T& value, T min, T max, const char* format = nullptr, ImGuiSliderFlags flags = 0)
+{
+    constexpr ImGuiDataType type = std::is_same_v<T, float> ? ImGuiDataType_Float : ImGuiDataType_U32;
+    return ImGui::SliderScalar(label, type, &value, &min, &max, format, flags);
+}
+
+void Perf_Overlay::draw(Rope_Settings& settings, const GPU_Timers& gpu_timers)
+{
+    if (ImGui::IsKeyPressed(ImGuiKey_F1, false))
+        m_visible = !m_visible;
+
+    if (!m_visible)
+        return;
+
+    ImGui::SetNextWindowBgAlpha(0.75f);
+    ImGui::SetNextWindowSize(ImVec2(360.0f, 0.0f), ImGuiCond_FirstUseEver);
+
+    if (ImGui::Begin("Performance", &m_visible, ImGuiWindowFlags_NoSavedSettings))
+    {
+        if (ImGui::CollapsingHeader("Knobs", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            slider("iterations", settings.iterations, 1u, 64u);
+            slider("substeps", settings.substeps, 1u, 8u);
+            slider("tolerance", settings.tolerance, 0.0f, 0.1f, "%.5f", ImGuiSliderFlags_Logarithmic);
+            slider("threads", settings.threads, 1u, g_thread_pool.max_threads());
+
+            // each rope is one task, a single rope only ever runs on one thread
+            slider("ropes", settings.ropes, 1u, 256u, nullptr, ImGuiSliderFlags_Logarithmic);
+            slider("nodes per rope", settings.nodes, 2u, 16384u, nullptr, ImGuiSliderFlags_Logarithmic);
+        }
+
+        // stages are cpu time summed over every thread, the step is wall time
+        if (ImGui::CollapsingHeader("CPU ms", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            plot("step", m_wall_ms, "ms");
+
+            for (u32 stage = 0u; stage < SIM_STAGE_MAX; ++stage)
+                plot(sim_stage_names[stage], m_stage_ms[stage], "ms");
+        }
+
+        // passes that never ran (e.g. a layer that's always cached) have nothing to show
+        if (gpu_timers.enabled() && ImGui::CollapsingHeader("GPU ms", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            for (u32 pass = 0u; pass < gpu_timers.passes(); ++pass)
+            {
+                if (!gpu_timers.stats(pass).empty())
+                    plot(gpu_timers.name(pass), gpu_timers.stats(pass), "ms");
+            }
+        }
+
+        if (ImGui::CollapsingHeader("Scene"))
+        {
+            plot("nodes", m_nodes);
+            plot("circles", m_circles);
+            plot("candidate pairs", m_candidate_pairs);
+            plot("contacts", m_contacts);
+        }
+
+        if (ImGui::CollapsingHeader("Solver"))
+        {
+            plot("iterations", m_iterations);
+            plot("residual", m_residual);
+        }
+
+        if (ImGui::CollapsingHeader("Allocations"))
+            plot("allocs/frame", m_allocs);
+    }
+
+    ImGui::End();
+}
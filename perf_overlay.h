@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+
+#include "rope.h"
+#include "gpu_timers.h"
+#include "allocation.h"
+#include "stats.h"
+
+// live graphs of what the simulation and renderer did over the last few seconds, next to the rope's knobs so a scene can
+// be tuned while watching what it costs. F1 toggles it, samples are pushed whether it's shown or not
+class Perf_Overlay
+{
+    std::array<Rolling_Stats, SIM_STAGE_MAX> m_stage_ms;
+    Rolling_Stats                            m_wall_ms;
+    Rolling_Stats                            m_nodes;
+    Rolling_Stats                            m_circles;
+    Rolling_Stats                            m_candidate_pairs;
+    Rolling_Stats                            m_contacts;
+    Rolling_Stats                            m_iterations;
+    Rolling_Stats                            m_residual;
+    Rolling_Stats                            m_allocs;
+    bool                                     m_visible;
+
+public:
+    Perf_Overlay(bool visible = false);
+
+    void push(const Rope_Stats& stats, const Alloc_Stats& frame_allocs);
+
+    // knob changes are written straight into settings and apply from the next simulate()
+    void draw(Rope_Settings& settings, const GPU_Timers& gpu_timers);
+};
@@ -0,0 +1,96 @@
+#include <print>
+#include <format>
+#include <fstream>
+#include <utility>
+
+#include "profiler.h"
+
+// each thread finds its buffer without touching the shared list after the first event
+thread_local Trace_Buffer* t_trace_buffer = nullptr;
+
+Trace_Buffer& Profiler::thread_buffer()
+{
+    if (t_trace_buffer != nullptr)
+        return *t_trace_buffer;
+
+    std::scoped_lock lock(m_mutex);
+
+    m_buffers.push_back(std::make_unique<Trace_Buffer>((u32)m_buffers.size()));
+    t_trace_buffer = m_buffers.back().get();
+
+    return *t_trace_buffer;
+}
+
+void Profiler::record(const char* name, u64 begin, u64 end, Alloc_Stats allocs)
+{
+    Trace_Buffer& buffer = thread_buffer();
+
+    const u32 index = buffer.m_count.load(std::memory_order_relaxed);
+    if (index >= Trace_Buffer::capacity)
+    {
+        ++buffer.m_dropped;
+        return;
+    }
+
+    buffer.m_events[index] = Profile_Event{name, begin, end, allocs};
+    buffer.m_count.store(index + 1u, std::memory_order_release);
+}
+
+void Profiler::set_thread_name(const char* name)
+{
+    thread_buffer().m_thread_name = name;
+}
+
+bool Profiler::dump(const std::filesystem::path& path)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        std::print("failed to open {} for the trace\n", path.string());
+        return false;
+    }
+
+    std::scoped_lock lock(m_mutex);
+
+    std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool        first = true;
+
+    auto separator = [&]() { return std::exchange(first, false) ? "" : ",\n"; };
+
+    for (auto& buffer : m_buffers)
+    {
+        const std::string thread_name = buffer->m_thread_name != nullptr ? buffer->m_thread_name : std::format("thread {}", buffer->m_thread_id);
+
+        json += std::format(
+            "{}{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}",
+            separator(),
+            buffer->m_thread_id,
+            thread_name
+        );
+
+        const u32 count = buffer->m_count.load(std::memory_order_acquire);
+        for (u32 i = 0u; i < count; ++i)
+        {
+            const Profile_Event& event = buffer->m_events[i];
+
+            json += std::format(
+                "{}{{\"name\": \"{}\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {{\"allocs\": {}, \"bytes\": {}}}}}",
+                separator(),
+                event.m_name,
+                buffer->m_thread_id,
+                event.m_begin / 1000.0,
+                (event.m_end - event.m_begin) / 1000.0,
+                event.m_allocs.m_count,
+                event.m_allocs.m_bytes
+            );
+        }
+
+        if (buffer->m_dropped > 0u)
+            std::print("{} dropped {} profile events, its trace buffer was full\n", thread_name, buffer->m_dropped);
+    }
+
+    json += "\n]}\n";
+    file << json;
+
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+#include "allocation.h"
+#include "types.h"
+
+// PROFILE_SCOPE("name") times the rest of the enclosing scope into a chrome trace (load the dump in ui.perfetto.dev or
+// chrome://tracing). it compiles to nothing unless ROPE_DEMO_PROFILE is defined, names have to be string literals
+#if defined(ROPE_DEMO_PROFILE)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b)       PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)        Profile_Scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+struct Profile_Event
+{
+    const char* m_name;
+    u64         m_begin; // ns since the profiler's epoch
+    u64         m_end;
+    Alloc_Stats m_allocs; // heap allocations made inside the scope, nested scopes included
+};
+
+// events recorded by a single thread, only that thread ever writes to it so recording takes no locks
+class Trace_Buffer
+{
+public:
+    static constexpr u32 capacity = 1u << 19u; // events kept per thread, later ones are dropped
+
+    std::vector<Profile_Event> m_events;
+    std::atomic<u32>           m_count; // published with release so a dump can run while the thread is still recording
+    u64                        m_dropped;
+    u32                        m_thread_id;
+    const char*                m_thread_name;
+
+    Trace_Buffer(u32 thread_id) : m_events(capacity), m_count(), m_dropped(), m_thread_id(thread_id), m_thread_name() {}
+};
+
+class Profiler
+{
+    std::mutex                                 m_mutex; // only taken when a thread records its first event and when dumping
+    std::vector<std::unique_ptr<Trace_Buffer>> m_buffers;
+    std::chrono::steady_clock::time_point      m_epoch;
+
+    Trace_Buffer& thread_buffer();
+
+public:
+    Profiler() : m_mutex(), m_buffers(), m_epoch(std::chrono::steady_clock::now()) {}
+
+    u64 now() const { return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count(); }
+
+    void record(const char* name, u64 begin, u64 end, Alloc_Stats allocs);
+
+    // shows up as the track name in the trace, the string has to outlive the profiler
+    void set_thread_name(const char* name);
+
+    // chrome trace event format, complete ("X") events with microsecond timestamps
+    bool dump(const std::filesystem::path& path);
+};
+
+inline Profiler g_profiler;
+
+class Profile_Scope
+{
+    const char* m_name;
+    u64         m_begin;
+    Alloc_Stats m_allocs;
+
+public:
+    Profile_Scope(const char* name) : m_name(name), m_begin(g_profiler.now()), m_allocs(thread_alloc_stats()) {}
+
+    ~Profile_Scope()
+    {
+        const Alloc_Stats allocs = thread_alloc_stats();
+        g_profiler.record(m_name, m_begin, g_profiler.now(), {allocs.m_count - m_allocs.m_count, allocs.m_bytes - m_allocs.m_bytes});
+    }
+
+    Profile_Scope(const Profile_Scope&)            = delete;
+    Profile_Scope& operator=(const Profile_Scope&) = delete;
+};
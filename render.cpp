@@ -1,8 +1,16 @@
 #include <print>
 #include <numeric>
+#include <fstream>
 #include <optional>
+#include <iterator>
+#include <chrono>
+#include <algorithm>
 
 #include "render.h"
+#include "gl_state.h"
+#include "profiler.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
 #include "rope.h"
 
 // heavily based off of https://github.com/ocornut/imgui/blob/master/examples/example_sdl3_opengl3/main.cpp
@@ -19,7 +27,28 @@ SDL_HitTestResult SDLCALL hit_test_callback(SDL_Window* win, const SDL_Point* ar
     return SDL_HITTEST_NORMAL;
 }
 
-Render::Render() : m_window(), m_gl_ctx(), m_quit(true), m_screen_size(570.0f, 700.0f) {}
+Render::Render(const Render_Settings& settings) :
+    m_settings(settings), m_window(), m_gl_ctx(), m_quit(true), m_screen_size(570.0f, 700.0f), m_frame_times(600u), m_frame_arena(64u * 1024u),
+    m_frame_allocs(), m_perf_overlay(settings.overlay), m_ropes()
+{}
+
+// ImGui's backend restores everything it touches once it's done, so whatever the cache knew beforehand still holds
+// (callbacks invalidate it while ImGui's own state is bound, hence the copy)
+static void render_draw_data(ImDrawData* draw_data)
+{
+    const GL_State state = g_gl_state;
+    ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+    g_gl_state = state;
+}
+
+// gpu pass of each layer and of its blur
+constexpr std::array<std::array<Gpu_Pass, 2u>, LAYER_MAX> layer_passes = {{
+    {GPU_PASS_BG, GPU_PASS_BG_BLUR},
+    {GPU_PASS_GAME, GPU_PASS_GAME_BLUR},
+}};
+
+// frames --alloc-check lets through before enforcing, enough for every container and ImGui to reach their steady size
+constexpr u32 alloc_warmup_frames = 120u;
 
 void Render::run()
 {
@@ -30,21 +59,98 @@ void Render::run()
         return;
     }
 
+    // cpu + gpu time of each frame when headless, the gpu is synced every frame so the two can't overlap
+    std::vector<float> headless_frame_times{};
+    if (m_settings.headless)
+        headless_frame_times.reserve(m_settings.headless_frames);
+
+    // heap allocations made by the frames after the warm-up, on any thread
+    Alloc_Stats steady_allocs{};
+    u64         frame_index = 0u;
+
     while (m_quit)
     {
-        SDL_Event event;
-        while (SDL_PollEvent(&event))
+        const auto        frame_start   = std::chrono::steady_clock::now();
+        const Alloc_Stats allocs_before = process_alloc_stats();
+
+        std::optional<Alloc_Forbid_Scope> forbid_allocs{};
+        if (m_settings.alloc_check && frame_index >= alloc_warmup_frames)
+            forbid_allocs.emplace();
+
         {
-            ImGui_ImplSDL3_ProcessEvent(&event);
+            PROFILE_SCOPE("events");
+
+            SDL_Event event;
+            while (SDL_PollEvent(&event))
+            {
+                ImGui_ImplSDL3_ProcessEvent(&event);
 
-            if (event.type == SDL_EVENT_QUIT)
-                m_quit = false;
+                if (event.type == SDL_EVENT_QUIT)
+                    m_quit = false;
+            }
         }
 
         frame();
         render();
+
+        {
+            PROFILE_SCOPE("pacing");
+            m_frame_limiter.wait();
+        }
+
+        const Alloc_Stats allocs_after = process_alloc_stats();
+        m_frame_allocs                 = {allocs_after.m_count - allocs_before.m_count, allocs_after.m_bytes - allocs_before.m_bytes};
+
+        if (frame_index++ >= alloc_warmup_frames)
+        {
+            steady_allocs.m_count += m_frame_allocs.m_count;
+            steady_allocs.m_bytes += m_frame_allocs.m_bytes;
+        }
+
+        if (!m_settings.headless)
+            continue;
+
+        glFinish();
+        headless_frame_times.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
+
+        if (headless_frame_times.size() >= m_settings.headless_frames)
+            m_quit = false;
+    }
+
+    if (m_settings.headless)
+    {
+        print_headless_timings(headless_frame_times);
+
+        if (frame_index > alloc_warmup_frames)
+        {
+            const u64 frames = frame_index - alloc_warmup_frames;
+            std::print("heap allocations after warm-up: {} over {} frames ({} bytes)\n", steady_allocs.m_count, frames, steady_allocs.m_bytes);
+        }
+    }
+
+    if (!m_settings.trace_dump.empty())
+        g_profiler.dump(m_settings.trace_dump);
+
+    g_perf_counters.print();
+
+    // whatever is still in flight is waited on, we're done rendering anyway
+    m_gpu_timers.flush();
+
+    if (m_settings.headless)
+        m_gpu_timers.print();
+
+    if (m_settings.headless && m_frame_limiter.mode() != PACING_OFF)
+    {
+        const Rolling_Stats& jitter = m_frame_limiter.jitter();
+        std::print("pacing jitter ms average: {:.3f} p95: {:.3f} max: {:.3f}\n", jitter.mean(), jitter.percentile(0.95f), jitter.max());
     }
 
+    if (!m_settings.frame_times_dump.empty())
+        dump_frame_times(m_settings.frame_times_dump);
+
+    if (m_gpu_timers.enabled() && !m_settings.gpu_timers_dump.empty())
+        m_gpu_timers.dump(m_settings.gpu_timers_dump);
+
     // cleanup
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL3_Shutdown();
@@ -55,40 +161,144 @@ void Render::run()
     SDL_Quit();
 }
 
-std::string Render::get_fps_display()
+std::string_view Render::get_fps_display()
 {
-    static std::string          display{};
-    static float                last_update_time{};
-    static std::optional<float> min_fps{};
+    // formatted in place so updating it never allocates
+    static std::array<char, 192> display{};
+    static size_t                display_size{};
+    static float                 last_update_time{};
+    static double                window_total{};
+    static u32                   window_frames{};
+
+    // wall time between the last two frames, pacing included. ImGui's Framerate is already a moving average so it's no
+    // good for percentiles. the first frame has nothing to measure against
+    if (!m_frame_limiter.intervals().empty())
+    {
+        const float frame_ms = m_frame_limiter.intervals().latest();
 
-    // store our fps and min fps, this is called each frame
-    m_fps_history.push_back(ImGui::GetIO().Framerate);
-    min_fps = std::min(min_fps.value_or(m_fps_history.back() + 1.0f), m_fps_history.back());
+        m_frame_times.push(frame_ms);
+        m_frame_histogram.push(frame_ms);
+        window_total += frame_ms;
+        ++window_frames;
+    }
 
-    // update the display text every 0.5s
-    if (display.empty() || (float)ImGui::GetTime() - last_update_time > 0.5f)
+    // update the display text every 0.5s, the average covers just that window and the percentiles the whole run
+    if (display_size == 0u || (float)ImGui::GetTime() - last_update_time > 0.5f)
     {
-        const float average_fps = std::accumulate(m_fps_history.begin(), m_fps_history.end(), 0.0f) / m_fps_history.size();
+        const float window_ms = window_frames == 0u ? 0.0f : (float)(window_total / window_frames);
+
+        char* const end = display.data() + display.size();
+        char*       out = display.data();
+
+        const auto result = std::format_to_n(
+            out,
+            end - out,
+            "FPS: {:.1f} Frame: {:.2f}ms p50: {:.2f} p95: {:.2f} p99: {:.2f} Max: {:.2f} Allocs: {}",
+            window_ms > 0.0f ? 1000.0f / window_ms : 0.0f,
+            window_ms,
+            m_frame_histogram.percentile(0.50f),
+            m_frame_histogram.percentile(0.95f),
+            m_frame_histogram.percentile(0.99f),
+            m_frame_histogram.max(),
+            m_frame_allocs.m_count
+        );
+        out = result.out;
+
+        // how far frames land from where the pacing wanted them
+        if (m_frame_limiter.mode() != PACING_OFF)
+            out = std::format_to_n(out, end - out, " Jitter: {:.2f}ms", m_frame_limiter.jitter().mean()).out;
+
+        display_size = (size_t)(std::min(out, end) - display.data());
 
-        display          = std::format("FPS: {:.1f} Average: {:.1f} Min: {:.1f}", m_fps_history.back(), average_fps, min_fps.value_or(0.0f));
         last_update_time = (float)ImGui::GetTime();
+        window_total     = 0.0;
+        window_frames    = 0u;
+    }
+
+    return std::string_view(display.data(), display_size);
+}
+
+bool Render::dump_frame_times(const std::filesystem::path& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        std::print("failed to open {} for the frame times\n", path.string());
+        return false;
     }
 
-    return display;
+    std::string recent{};
+    m_frame_times.for_each([&](float ms) { recent += std::format("{}{:.4f}", recent.empty() ? "" : ", ", ms); });
+
+    file << std::format(
+        "{{\n  \"frames\": {},\n  \"mean_ms\": {:.4f},\n  \"p50_ms\": {:.4f},\n  \"p95_ms\": {:.4f},\n  \"p99_ms\": {:.4f},\n  \"max_ms\": {:.4f},\n"
+        "  \"histogram\": {},\n  \"recent_ms\": [{}]\n}}\n",
+        m_frame_histogram.count(),
+        m_frame_histogram.mean(),
+        m_frame_histogram.percentile(0.50f),
+        m_frame_histogram.percentile(0.95f),
+        m_frame_histogram.percentile(0.99f),
+        m_frame_histogram.max(),
+        m_frame_histogram.buckets_json(),
+        recent
+    );
+
+    return true;
+}
+
+void Render::print_headless_timings(const std::vector<float>& frame_times)
+{
+    if (frame_times.empty())
+        return;
+
+    std::vector<float> sorted = frame_times;
+    std::sort(sorted.begin(), sorted.end());
+
+    auto percentile = [&](float p)
+    {
+        return sorted[std::min(sorted.size() - 1u, (size_t)(p * sorted.size()))];
+    };
+
+    const float total = std::accumulate(sorted.begin(), sorted.end(), 0.0f);
+
+    // a broken context can give us null
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    if (!renderer)
+        renderer = "unknown";
+
+    std::print("renderer: {}\n", renderer);
+    std::print("frames: {} total: {:.1f}ms average fps: {:.1f}\n", sorted.size(), total, sorted.size() * 1000.0f / total);
+    std::print(
+        "frame ms min: {:.3f} average: {:.3f} p50: {:.3f} p95: {:.3f} p99: {:.3f} max: {:.3f}\n",
+        sorted.front(),
+        total / sorted.size(),
+        percentile(0.50f),
+        percentile(0.95f),
+        percentile(0.99f),
+        sorted.back()
+    );
 }
 
 bool Render::init()
 {
+    if (m_settings.headless)
+    {
+        // no display server, render into an EGL pbuffer. prefer Mesa's llvmpipe unless the user picked a driver already
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+        SDL_setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+        SDL_setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO) != 0)
     {
-        std::print("%s\n", SDL_GetError());
+        std::print("{}\n", SDL_GetError());
         return false;
     }
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
     // Enable native IME.
     SDL_SetHint(SDL_HINT_IME_SHOW_UI, "1");
@@ -104,20 +314,35 @@ bool Render::init()
 
     if (m_window == nullptr)
     {
-        std::print("%s\n", SDL_GetError());
+        std::print("{}\n", SDL_GetError());
         return false;
     }
 
     SDL_SetWindowPosition(m_window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
     m_gl_ctx = SDL_GL_CreateContext(m_window);
+
+    if (m_gl_ctx == nullptr)
+    {
+        std::print("{}\n", SDL_GetError());
+        return false;
+    }
+
     SDL_GL_MakeCurrent(m_window, m_gl_ctx);
-    SDL_GL_SetSwapInterval(0); // disable vsync
+    m_frame_limiter.init(m_settings.pacing, m_settings.target_fps);
     SDL_ShowWindow(m_window);
 
-    gladLoadGL();
+    // through SDL, so the functions come from the same library as the context (EGL when headless)
+    if (gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress) == 0)
+    {
+        std::print("couldn't load the OpenGL functions\n");
+        return false;
+    }
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
+
+    // count ImGui's allocations along with ours
+    ImGui::SetAllocatorFunctions(imgui_alloc, imgui_free);
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
     (void)io;
@@ -137,18 +362,63 @@ bool Render::init()
     if (!m_shaders.load_shaders())
         return false;
 
+    // pick up shader edits while we're running, new programs are compiled in the background where the driver supports it
+    if (!m_settings.headless)
+    {
+        Max_Shader_Compiler_Threads_Fn max_compiler_threads = nullptr;
+
+        if (SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile"))
+            max_compiler_threads = (Max_Shader_Compiler_Threads_Fn)SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsKHR");
+
+        else if (SDL_GL_ExtensionSupported("GL_ARB_parallel_shader_compile"))
+            max_compiler_threads = (Max_Shader_Compiler_Threads_Fn)SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsARB");
+
+        m_shaders.enable_hot_reload(max_compiler_threads);
+    }
+
+    if (!m_rope_renderer.init(m_shaders) || !m_circle_renderer.init(m_shaders))
+        return false;
+
+    // timer queries are core in 3.3, llvmpipe included
+    if (m_settings.gpu_timers)
+        m_gpu_timers.init(gpu_pass_names);
+
+    // every worker is started now, the overlay's thread count only picks how many take part
+    g_thread_pool.init();
+
+    // the simulation runs on this thread, opening its counters here keeps the syscalls out of the first frame
+    if (m_settings.perf_counters)
+        g_perf_counters.init();
+
     return true;
 }
 
 void Render::frame()
 {
+    PROFILE_SCOPE("frame");
+
+    // nothing allocated from the arena last frame is still referenced
+    m_frame_arena.reset();
+
     if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
     {}
 
+    // swap in any shader that finished hot reloading, programs never change mid-frame
+    m_shaders.poll_reloads();
+
     // setup ImGui for a new frame
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplSDL3_NewFrame();
-    ImGui::NewFrame();
+    {
+        PROFILE_SCOPE("imgui_new_frame");
+
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplSDL3_NewFrame();
+
+        // use a fixed timestep when headless so runs with the same seed simulate identically
+        if (m_settings.headless)
+            ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+
+        ImGui::NewFrame();
+    }
 
     // set the next ImGui window to the size of the parent window, set it's relative position to 0
     ImGui::SetNextWindowSize(m_screen_size);
@@ -157,7 +427,10 @@ void Render::frame()
     // ImGui cringe
     static bool show = true;
 
-    const std::string window_name = std::format("Rope Demo({})", get_fps_display());
+    // the title changes every update, ### keeps the window's id stable so ImGui doesn't create a new window each time
+    std::pmr::string window_name(m_frame_arena.resource());
+    std::format_to(std::back_inserter(window_name), "Rope Demo({})###rope_demo", get_fps_display());
+
     if (!ImGui::Begin(window_name.c_str(), &show, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoResize))
         return;
 
@@ -192,116 +465,181 @@ void Render::frame()
     {
         if (m_layers.empty())
         {
-            m_layers["bg"]   = Layer();
-            m_layers["game"] = Layer();
+            m_layers.reserve(LAYER_MAX);
+            for (u32 id = 0u; id < LAYER_MAX; ++id)
+                m_layers.emplace_back(id == LAYER_BG ? m_settings.bg_scale : 1.0f);
+
+            // the background sits behind a heavy blur
+            const glm::ivec2 display_size = glm::vec2(ImGui::GetIO().DisplaySize);
+            m_layers[LAYER_BG].m_blur.emplace(m_shaders, m_layers[LAYER_BG].m_size, display_size, m_settings.bg_blur, m_settings.bg_blur_strength);
         }
 
-        for (auto& [name, layer] : m_layers)
+        // a reloaded shader invalidates every cached layer
+        for (auto& layer : m_layers)
+        {
             layer.on_new_frame();
+            layer.hash_content(m_shaders.generation());
+        }
+
+        m_rope_renderer.on_new_frame();
+        m_circle_renderer.on_new_frame();
     }
 
     ImGui::GetForegroundDrawList()->AddRectFilled(m_min, m_max, IM_COL32(0, 0, 0, 1));
 
-    // finally, draw our rope
-    static Rope rope{};
-    rope.simulate();
-    rope.draw();
+    // the overlay's scene knobs rebuild every rope, the rest of them apply from the next step
+    Rope_Settings& rope_settings = m_settings.rope;
+    rope_settings.nodes          = std::max(rope_settings.nodes, 2u);
+
+    if (m_ropes.size() != rope_settings.ropes || (!m_ropes.empty() && m_ropes[0].m_nodes.size() != rope_settings.nodes))
+        m_ropes = make_ropes(m_min, m_max, rope_settings, rope_settings.ropes, rope_settings.nodes);
+
+    for (auto& rope : m_ropes)
+    {
+        rope.m_settings = rope_settings;
+        rope.m_min      = m_min;
+        rope.m_max      = m_max;
+    }
+
+    // finally, draw our ropes. they hang side by side from the mouse
+    const glm::vec2  spacing = glm::vec2(Node::m_rest_length * 2.0f, 0.0f);
+    const Rope_Stats stats   = simulate_ropes(m_ropes, ImGui::GetIO().DeltaTime, ImGui::GetMousePos(), spacing, rope_settings.threads);
+
+    for (auto& rope : m_ropes)
+        rope.draw();
+
+    m_perf_overlay.push(stats, m_frame_allocs);
+
+    {
+        PROFILE_SCOPE("draw_lists");
+
+        build_layers(rope_settings.threads);
+
+        m_circle_renderer.draw(get_dl(LAYER_BG));
+        m_rope_renderer.draw(get_dl(LAYER_GAME));
+    }
+
+    m_gpu_timers.draw_overlay();
+    m_perf_overlay.draw(rope_settings, m_gpu_timers);
 
     ImGui::End();
 }
 
+// items per chunk when filling the batches, each one is a handful of stores so it takes a lot of them to pay for a wake up
+constexpr u32 min_items_per_task = 4096u;
+
+// fills every layer's batches and hashes them into the layer. chunks write disjoint ranges of slots reserved in the order
+// things were added, so the result is the same as filling them serially on any number of threads
+void Render::build_layers(u32 threads)
+{
+    const u32 circles = m_circle_renderer.queued();
+    const u32 nodes   = m_rope_renderer.queued();
+
+    // both layers share one loop, a small layer doesn't leave threads waiting while another one is still being filled
+    {
+        PROFILE_SCOPE("build_batches");
+
+        g_thread_pool.parallel_for(circles + nodes, threads, min_items_per_task, [&](u32 begin, u32 end)
+        {
+            if (begin < circles)
+                m_circle_renderer.build(begin, std::min(end, circles));
+
+            if (end > circles)
+                m_rope_renderer.build(std::max(begin, circles) - circles, end - circles);
+        });
+    }
+
+    // a hash has to run over its batch in order, so each layer is one task
+    PROFILE_SCOPE("hash_batches");
+
+    std::array<u64, LAYER_MAX> hashes{};
+    const u32                  hash_threads = circles + nodes >= min_items_per_task ? threads : 1u;
+
+    g_thread_pool.parallel_for(LAYER_MAX, hash_threads, 1u, [&](u32 begin, u32 end)
+    {
+        for (u32 id = begin; id < end; ++id)
+            hashes[id] = id == LAYER_BG ? m_circle_renderer.hash() : m_rope_renderer.hash();
+    });
+
+    for (u32 id = 0u; id < LAYER_MAX; ++id)
+        m_layers[id].hash_content(hashes[id]);
+}
+
 void Render::render()
 {
     static const ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
     ImGuiIO&            io          = ImGui::GetIO();
 
-    ImGui::Render();
+    PROFILE_SCOPE("render");
 
-    glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
+    {
+        PROFILE_SCOPE("imgui_render");
+        ImGui::Render();
+    }
+
+    m_gpu_timers.on_new_frame();
+    m_gpu_timers.begin(GPU_PASS_FRAME);
+
+    g_gl_state.viewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
     glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
     ImGui::GetForegroundDrawList()->PushClipRect(m_min, m_max);
 
     // render each layer to it's own framebuffer/texture and add the resulting texture to the final drawlist
-    for (auto& [name, layer] : m_layers)
+    for (u32 id = 0u; id < m_layers.size(); ++id)
     {
-        // make sure the layer actually has something drawn on it, by default each layer has one ImDrawCmd
-        // if (layer.m_dl->CmdBuffer.back().ElemCount == 0u)
-        // continue;
+        PROFILE_SCOPE("layer");
 
-        layer.on_render();
+        // nothing was drawn on this layer
+        const GLuint texture = m_layers[id].on_render(m_gpu_timers, layer_passes[id][0], layer_passes[id][1]);
+        if (texture == 0u)
+            continue;
 
-        if (name == "bg")
-        {
-            ImGui::GetForegroundDrawList()->AddCallback(
-                [](const ImDrawList* dl, const ImDrawCmd* cmd)
-                {
-                    ImDrawData* draw_data = ImGui::GetDrawData();
-                    float       L         = draw_data->DisplayPos.x;
-                    float       R         = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
-                    float       T         = draw_data->DisplayPos.y;
-                    float       B         = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
-
-                    const auto ortho = glm::ortho(L, R, B, T);
-
-                    auto layer          = (Layer*)cmd->UserCallbackData;
-                    auto shader         = g_render->m_shaders.get_shader("gaussian");
-                    auto shader_program = shader.m_shader_program;
-
-                    g_render->m_shaders.activate_shader(shader);
-
-                    glUniformMatrix4fv(glGetUniformLocation(shader_program, "u_projection"), 1, GL_FALSE, &ortho[0][0]);
-                    glUniform2f(glGetUniformLocation(shader_program, "u_resolution"), ImGui::GetIO().DisplaySize.x, ImGui::GetIO().DisplaySize.y);
-                    glUniform1i(glGetUniformLocation(shader_program, "u_kernel_size"), 2);
-
-                    GLenum last_active_texture{};glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
-                    glActiveTexture(GL_TEXTURE0 + layer->m_texture);
-                    glBindTexture(GL_TEXTURE_2D, layer->m_texture);
-                    glUniform1i(glGetUniformLocation(shader_program, "u_tex"), layer->m_texture);
-                    glActiveTexture(last_active_texture);
-                },
-                &layer
-            );
-        }
-
-        ImGui::GetForegroundDrawList()->AddImage(
-            (ImTextureID)layer.m_texture, ImVec2(0.0f, 0.0f), io.DisplaySize, ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f)
-        );
-        ImGui::GetForegroundDrawList()->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+        ImGui::GetForegroundDrawList()->AddImage((ImTextureID)texture, ImVec2(0.0f, 0.0f), io.DisplaySize, ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f));
     }
 
     ImGui::GetForegroundDrawList()->PopClipRect();
 
     // bind the default framebuffer and render to screen
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    g_gl_state.bind_framebuffer(0);
+    {
+        PROFILE_SCOPE("composite");
 
+        m_gpu_timers.begin(GPU_PASS_COMPOSITE);
+        render_draw_data(ImGui::GetDrawData());
+        m_gpu_timers.end(GPU_PASS_COMPOSITE);
+    }
+
+    m_gpu_timers.end(GPU_PASS_FRAME);
+
+    PROFILE_SCOPE("swap");
     SDL_GL_SwapWindow(m_window);
 }
 
-std::shared_ptr<ImDrawList> Render::get_dl(std::string_view name)
+ImDrawList& Render::get_dl(Layer_Id id)
 {
-    return m_layers[name.data()].m_dl;
+    return *m_layers[id].m_dl;
 }
 
-Render::Layer::Layer() : m_fbo(), m_rbo(), m_texture()
+Render::Layer::Layer(float scale) :
+    m_fbo(), m_rbo(), m_texture(), m_scale(scale), m_content_hash(fnv1a_basis), m_rendered_hash(), m_result()
 {
-    const ImVec2 framebuffer_size = ImGui::GetIO().DisplaySize;
+    // reduced resolution layers are upsampled with linear filtering when they're composited
+    m_size = glm::max(glm::ivec2(glm::vec2(ImGui::GetIO().DisplaySize) * m_scale), glm::ivec2(1));
 
     // gen a new framebuffer and bind it
     glGenFramebuffers(1, &m_fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    g_gl_state.bind_framebuffer(m_fbo);
 
     // set up our texture
     glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    g_gl_state.bind_texture(m_texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei)framebuffer_size.x, (GLsizei)framebuffer_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
     // bind texture to framebuffer
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
@@ -309,17 +647,17 @@ Render::Layer::Layer() : m_fbo(), m_rbo(), m_texture()
     // gen a new render buffer and bind it
     glGenRenderbuffers(1, &m_rbo);
     glBindRenderbuffer(GL_RENDERBUFFER, m_rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, (GLsizei)framebuffer_size.x, (GLsizei)framebuffer_size.y);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_size.x, m_size.y);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_rbo);
 
     if (auto res = glCheckFramebufferStatus(GL_FRAMEBUFFER); res != GL_FRAMEBUFFER_COMPLETE)
         std::print("framebuffer incomplete: 0x{:X}\n", res);
 
     // bind the default frame and render buffers
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    g_gl_state.bind_framebuffer(0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
-    m_dl       = std::make_shared<ImDrawList>(ImGui::GetDrawListSharedData());
+    m_dl       = std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData());
     m_drawdata = std::make_unique<ImDrawData>();
 
     m_dl->AddDrawCmd();
@@ -331,19 +669,64 @@ void Render::Layer::on_new_frame()
     m_drawdata->Valid            = true;
     m_drawdata->DisplayPos       = ImGui::GetMainViewport()->Pos;
     m_drawdata->DisplaySize      = ImGui::GetMainViewport()->Size;
-    m_drawdata->FramebufferScale = ImVec2(1.0f, 1.0f);
+    m_drawdata->FramebufferScale = ImVec2(m_scale, m_scale); // ImGui scales the viewport and clip rects down to our resolution
+
+    m_content_hash = fnv1a_basis;
 
     m_dl->_ResetForNewFrame();
     m_dl->PushClipRectFullScreen();
     m_dl->PushTextureID(ImGui::GetIO().Fonts->TexID);
 }
 
-void Render::Layer::on_render()
+void Render::Layer::hash_content(u64 hash)
 {
+    m_content_hash = hash_bytes(&hash, sizeof(hash), m_content_hash);
+}
+
+GLuint Render::Layer::on_render(GPU_Timers& timers, Gpu_Pass pass, Gpu_Pass blur_pass)
+{
+    // by default each layer has one empty ImDrawCmd, anything else means something was drawn or a callback was queued
+    auto has_callback = [](const ImDrawCmd& cmd) { return cmd.UserCallback != nullptr; };
+    if (m_dl->VtxBuffer.empty() && std::none_of(m_dl->CmdBuffer.begin(), m_dl->CmdBuffer.end(), has_callback))
+    {
+        m_result = 0u;
+        return m_result;
+    }
+
+    // everything that ends up in our texture, if none of it changed since last frame the cached result (blurred or not) is still good
+    u64 hash = m_content_hash;
+    hash     = hash_span<ImDrawVert>({m_dl->VtxBuffer.begin(), m_dl->VtxBuffer.end()}, hash);
+    hash     = hash_span<ImDrawIdx>({m_dl->IdxBuffer.begin(), m_dl->IdxBuffer.end()}, hash);
+    hash     = hash_span<ImDrawCmd>({m_dl->CmdBuffer.begin(), m_dl->CmdBuffer.end()}, hash);
+    hash     = hash_bytes(&m_drawdata->DisplayPos, sizeof(ImVec2), hash);
+    hash     = hash_bytes(&m_drawdata->DisplaySize, sizeof(ImVec2), hash);
+
+    if (m_result != 0u && hash == m_rendered_hash)
+        return m_result;
+
     m_drawdata->AddDrawList(m_dl.get());
 
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    // a reset nothing draws after only sets up state that ImGui's backend restores from its backup anyway
+    while (!m_dl->CmdBuffer.empty() && m_dl->CmdBuffer.back().ElemCount == 0u &&
+           (m_dl->CmdBuffer.back().UserCallback == nullptr || m_dl->CmdBuffer.back().UserCallback == ImDrawCallback_ResetRenderState))
+        m_dl->CmdBuffer.pop_back();
+
+    g_gl_state.bind_framebuffer(m_fbo);
     glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-    ImGui_ImplOpenGL3_RenderDrawData(m_drawdata.get());
+    timers.begin(pass);
+    render_draw_data(m_drawdata.get());
+    timers.end(pass);
+
+    m_rendered_hash = hash;
+    m_result        = m_texture;
+
+    if (m_blur)
+    {
+        timers.begin(blur_pass);
+        m_result = m_blur->apply(m_texture);
+        timers.end(blur_pass);
+    }
+
+    return m_result;
 }
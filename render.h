@@ -6,25 +6,20 @@
 // tell ImGui about our custom ImConfig header
 #define IMGUI_USER_CONFIG "rope_demo_imconfig.h"
 
-// omit min and max macros from Windows headers
-#define NOMINMAX
-
 // enable experimental glm features
 #define GLM_ENABLE_EXPERIMENTAL
 
-#include <Windows.h>
-
 #include <memory>
-#include <map>
+#include <vector>
 #include <atomic>
 
 #include <glad/glad.h>
-#include <glm\glm.hpp>
-#include <glm\ext.hpp>
-#include <glm\gtx\vector_angle.hpp>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <glm/gtx/vector_angle.hpp>
 
-#include <SDL3\SDL.h>
-#include <SDL3\SDL_opengl.h>
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_opengl.h>
 
 #include <imgui_internal.h>
 #include <imgui.h>
@@ -32,6 +27,87 @@
 #include <backends/imgui_impl_opengl3.h>
 
 #include "shaders.h"
+#include "blur.h"
+#include "hash.h"
+#include "gpu_timers.h"
+#include "frame_limiter.h"
+#include "allocation.h"
+#include "rope_renderer.h"
+#include "circle_renderer.h"
+#include "perf_overlay.h"
+
+struct Render_Settings
+{
+    // render through SDL's offscreen driver (EGL pbuffer) on Mesa's software rasterizer, no window or display needed
+    bool headless = false;
+
+    // frames to render before quitting when headless
+    u32 headless_frames = 1000u;
+
+    // how the background layer is blurred, strength is the radius for BLUR_GAUSSIAN and the pyramid depth for BLUR_DUAL_FILTER
+    Blur_Mode bg_blur          = BLUR_GAUSSIAN;
+    u32       bg_blur_strength = 4u;
+
+    // resolution of the background layer relative to the display, it's blurred heavily so it gets away with much less
+    float bg_scale = 0.5f;
+
+    // how frames are paced, target_fps only applies to PACING_SLEEP. headless runs default to PACING_OFF
+    Pacing_Mode pacing     = PACING_VSYNC;
+    float       target_fps = 60.0f;
+
+    // frame time percentiles, the histogram and the most recent frames are written here as json at exit if set
+    std::filesystem::path frame_times_dump{};
+
+    // once warmed up every frame must be allocation-free, any allocation is reported and asserts in debug builds
+    bool alloc_check = false;
+
+    // chrome trace of every PROFILE_SCOPE, written at exit. only has anything in it when built with ROPE_DEMO_PROFILE
+    std::filesystem::path trace_dump{};
+
+    // time every pass on the gpu and show the results in an overlay, also written as json to gpu_timers_dump at exit if set
+    bool                  gpu_timers = false;
+    std::filesystem::path gpu_timers_dump{};
+
+    // count cycles, instructions and cache/branch misses of each simulation stage and print them at exit, linux only
+    bool perf_counters = false;
+
+    // show the performance overlay from the start instead of waiting for F1
+    bool overlay = false;
+
+    // starting values of the knobs the overlay tunes
+    Rope_Settings rope{};
+};
+
+// layers are composited in this order, bottom to top
+enum Layer_Id : u8
+{
+    LAYER_BG = 0,
+    LAYER_GAME,
+
+    LAYER_MAX,
+};
+
+// passes timed by GPU_Timers, the frame contains all the others
+enum Gpu_Pass : u8
+{
+    GPU_PASS_FRAME = 0,
+    GPU_PASS_BG,
+    GPU_PASS_BG_BLUR,
+    GPU_PASS_GAME,
+    GPU_PASS_GAME_BLUR,
+    GPU_PASS_COMPOSITE,
+
+    GPU_PASS_MAX,
+};
+
+constexpr std::array<std::string_view, GPU_PASS_MAX> gpu_pass_names = {
+    "frame",
+    "bg",
+    "bg_blur",
+    "game",
+    "game_blur",
+    "composite",
+};
 
 class Render
 {
@@ -41,41 +117,62 @@ class Render
         GLuint                      m_fbo;
         GLuint                      m_rbo;
         GLuint                      m_texture;
-        std::shared_ptr<ImDrawList> m_dl;
+        float                       m_scale; // resolution relative to the display
+        glm::ivec2                  m_size;
+        std::unique_ptr<ImDrawList> m_dl;
         std::unique_ptr<ImDrawData> m_drawdata;
 
-        // shader stuff, this should probably be thrown into a class
-        std::optional<Shader>         m_shader;
-        std::optional<std::pair<ImDrawCallback*, void*>> m_shader_callback; // callback, callback data
+        // blurred before being composited, if set
+        std::optional<Blur> m_blur;
+
+        // content drawn through callbacks (e.g. instanced batches) isn't in the draw list, its owner hashes it in instead
+        u64    m_content_hash;
+        u64    m_rendered_hash; // hash of whatever m_result currently holds
+        GLuint m_result;        // texture to composite, 0 if nothing has been rendered yet
 
-        Layer();
+        Layer(float scale = 1.0f);
 
-        void on_new_frame();
-        void on_render();
+        void   on_new_frame();
+        void   hash_content(u64 hash);
+        GLuint on_render(GPU_Timers& timers, Gpu_Pass pass, Gpu_Pass blur_pass);
     };
-    using Layers = std::map<std::string, Layer>;
+    using Layers = std::vector<Layer>; // indexed by Layer_Id
 
+    Render_Settings    m_settings;
     SDL_Window*        m_window;
     SDL_GLContext      m_gl_ctx;
     ImVec2             m_screen_size;
     std::atomic_bool   m_quit;
     Shaders            m_shaders;
     Layers             m_layers;
-    std::vector<float> m_fps_history;
+    GPU_Timers         m_gpu_timers;
+    Frame_Limiter      m_frame_limiter;
+    Rolling_Stats      m_frame_times;     // ms, the last few seconds
+    Log_Histogram      m_frame_histogram; // ms, the whole run
+    Frame_Arena        m_frame_arena;     // transient allocations, reset at the start of every frame
+    Alloc_Stats        m_frame_allocs;    // heap allocations made during the last frame
+    Perf_Overlay       m_perf_overlay;
+    std::vector<Rope>  m_ropes;
 
     bool        init();
     void        frame();
     void        render();
-    std::string get_fps_display();
+    void        build_layers(u32 threads);
+    std::string_view get_fps_display();
+    void        print_headless_timings(const std::vector<float>& frame_times);
+    bool        dump_frame_times(const std::filesystem::path& path) const;
 
 public:
     ImVec2 m_min;
     ImVec2 m_max;
 
-    Render();
+    Rope_Renderer   m_rope_renderer;
+    Circle_Renderer m_circle_renderer;
+
+    Render(const Render_Settings& settings = {});
 
     void                        run();
-    std::shared_ptr<ImDrawList> get_dl(std::string_view name);
+    ImDrawList&                 get_dl(Layer_Id id);
 };
 
 inline std::shared_ptr<Render> g_render;
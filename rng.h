@@ -1,33 +1,91 @@
 #pragma once
 
+#include <array>
 #include <random>
 
 #include <glm/glm.hpp>
 
 #include "types.h"
 
+// counter-based generator (Philox4x32-10, Salmon et al. "Parallel Random Numbers: As Easy as 1, 2, 3")
+// every value is a pure function of (seed, entity, draw index), there's no shared state between generators
+// so any thread can reproduce any entity's random attributes regardless of the order they're created in
 class RNG
 {
-    std::random_device m_rd;
-    std::mt19937       m_gen;
+    using Block = std::array<u32, 4u>;
 
-    template <typename T>
-    using Distribution = std::conditional_t<std::is_integral_v<T>, std::uniform_int_distribution<T>, std::uniform_real_distribution<T>>;
+    u64   m_seed;
+    u64   m_entity;
+    u32   m_draw;
+    u32   m_cached_block;
+    Block m_block;
 
-    template <typename T>
-    Distribution<T> get_distribution(T min, T max)
+    static constexpr void mulhilo(u32 a, u32 b, u32& hi, u32& lo)
     {
-        static_assert(std::is_arithmetic_v<T>, "arithmetic types are required for rng");
-        return Distribution<T>(min, max);
+        const u64 product = (u64)a * b;
+
+        hi = (u32)(product >> 32u);
+        lo = (u32)product;
+    }
+
+    static constexpr Block philox(Block ctr, std::array<u32, 2u> key)
+    {
+        constexpr u32 multiplier_0 = 0xD2511F53u;
+        constexpr u32 multiplier_1 = 0xCD9E8D57u;
+        constexpr u32 weyl_0       = 0x9E3779B9u;
+        constexpr u32 weyl_1       = 0xBB67AE85u;
+
+        for (u32 round = 0u; round < 10u; ++round)
+        {
+            u32 hi_0, lo_0, hi_1, lo_1;
+            mulhilo(multiplier_0, ctr[0], hi_0, lo_0);
+            mulhilo(multiplier_1, ctr[2], hi_1, lo_1);
+
+            ctr = {hi_1 ^ ctr[1] ^ key[0], lo_1, hi_0 ^ ctr[3] ^ key[1], lo_0};
+
+            key[0] += weyl_0;
+            key[1] += weyl_1;
+        }
+
+        return ctr;
     }
 
 public:
-    RNG() : m_gen(m_rd()) {}
+    RNG(u64 seed, u64 entity, u32 draw = 0u) : m_seed(seed), m_entity(entity), m_draw(draw), m_cached_block(~0u), m_block() {}
 
+    // the raw 32 bits for a single draw, each philox block covers 4 consecutive draws
+    u32 next()
+    {
+        const u32 block = m_draw >> 2u;
+        if (block != m_cached_block)
+        {
+            m_block        = philox({block, 0u, (u32)m_entity, (u32)(m_entity >> 32u)}, {(u32)m_seed, (u32)(m_seed >> 32u)});
+            m_cached_block = block;
+        }
+
+        return m_block[m_draw++ & 3u];
+    }
+
+    // integers are in [min, max], floating point values are in [min, max)
     template <typename T>
     T get_random(T min, T max)
     {
-        return get_distribution<T>(min, max)(m_gen);
+        static_assert(std::is_arithmetic_v<T>, "arithmetic types are required for rng");
+
+        if constexpr (std::is_integral_v<T>)
+        {
+            static_assert(sizeof(T) <= sizeof(u32), "integers wider than 32 bits aren't supported");
+
+            // multiply-shift range reduction, the bias is negligible for the small ranges we use
+            const u64 range = (u64)((i64)max - (i64)min) + 1u;
+            return (T)((i64)min + (i64)(((u64)next() * range) >> 32u));
+        }
+        else
+        {
+            // 24 bits of mantissa, exact in a float
+            const T t = (T)(next() >> 8u) * (T)(1.0 / 16777216.0);
+            return min + t * (max - min);
+        }
     }
 
     glm::vec2 get_random(glm::vec2 min, glm::vec2 max)
@@ -41,4 +99,5 @@ class RNG
     }
 };
 
-inline RNG g_rng;
+// seed shared by every generator, fix it to make a run reproducible
+inline u64 g_rng_seed = ((u64)std::random_device{}() << 32u) | std::random_device{}();
@@ -1,130 +1,266 @@
 #include <print>
+#include <chrono>
 
 #include "render.h"
 #include "rope.h"
+#include "profiler.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
 
 // largely based off of https://www.cs.cmu.edu/afs/cs/academic/class/15462-s13/www/lec_slides/Jakobsen.pdf
 
 Node::Node(bool is_static, const glm::vec2& pos) : m_static(is_static), m_pos(pos), m_last_pos(pos) {}
 
-void Node::simulate()
+void Node::simulate(float timestep)
 {
     // we're a static node, don't need physics
     if (m_static)
         return;
 
-    const float timestep = ImGui::GetIO().DeltaTime;
-
     constexpr glm::vec2 gravity = glm::vec2(0.0f, 70.0f);
 
     m_velocity = m_pos - m_last_pos;
     m_last_pos = std::exchange(m_pos, m_pos + (m_velocity + gravity) * timestep);
 }
 
-void Node::constrain(Node& next_node)
+float Node::constrain(Node& next_node, const glm::vec2& min, const glm::vec2& max)
 {
     const glm::vec2 dir  = m_pos - next_node.m_pos;
     const float     dist = glm::length(dir);
 
     // just incase we try to divide by zero
     if (dist < 1e-6f)
-        return;
+        return 1.0f;
 
     const float     diff   = (dist - m_rest_length) / dist;
     const glm::vec2 offset = dir * 0.5f * diff;
 
     if (!m_static)
-        m_pos = glm::clamp(m_pos - offset, (glm::vec2)g_render->m_min, (glm::vec2)g_render->m_max);
+        m_pos = glm::clamp(m_pos - offset, min, max);
 
     if (!next_node.m_static)
-        next_node.m_pos = glm::clamp(next_node.m_pos + offset, (glm::vec2)g_render->m_min, (glm::vec2)g_render->m_max);
+        next_node.m_pos = glm::clamp(next_node.m_pos + offset, min, max);
+
+    return std::abs(dist - m_rest_length) / m_rest_length;
 }
 
-void Node::collide(const Circle& circle)
+bool Node::collide(const Circle& circle)
 {
     // static nodes don't have collision
     if (m_static)
-        return;
+        return false;
 
     const glm::vec2 dir  = m_pos - circle.m_pos;
     const float     dist = glm::length(dir);
 
     // are we colliding with the circle?
     if (dist > circle.m_radius)
-        return;
+        return false;
 
     m_pos += dir * ((circle.m_radius - dist) / dist);
+    return true;
 }
 
-Rope::Rope() : m_nodes()
+// adds the cpu time of the rest of the scope to a stage of the rope's stats
+class Stage_Timer
+{
+    float&                                m_ms;
+    std::chrono::steady_clock::time_point m_begin;
+
+public:
+    Stage_Timer(Rope_Stats& stats, Sim_Stage stage) : m_ms(stats.m_stage_ms[stage]), m_begin(std::chrono::steady_clock::now()) {}
+    ~Stage_Timer() { m_ms += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_begin).count(); }
+
+    Stage_Timer(const Stage_Timer&)            = delete;
+    Stage_Timer& operator=(const Stage_Timer&) = delete;
+};
+
+Rope::Rope(const glm::vec2& min, const glm::vec2& max, const Rope_Settings& settings, u32 nodes) :
+    m_settings(settings), m_stats(), m_min(min), m_max(max), m_nodes(), m_circles(), m_spawned_circles(), m_time(), m_last_spawn()
 {
-    glm::vec2 pos = (g_render->m_max - g_render->m_min) * 0.5f;
-    for (u32 i = 0u; i < 30u; ++i)
+    // all the storage we'll ever need up front, spawning a circle never allocates
+    m_nodes.reserve(nodes);
+    m_circles.reserve(m_settings.max_circles);
+
+    // every segment starts at its rest length. from the center the rope runs right and, whenever the next node would
+    // leave [min, max], drops down a segment and turns around, so long ropes fold back and forth instead of running away
+    glm::vec2 pos = (m_min + m_max) * 0.5f;
+    float     dir = 1.0f;
+    for (u32 i = 0u; i < nodes; ++i)
     {
-        pos.x += float(i) * Node::m_rest_length;
         m_nodes.push_back(Node(i == 0, pos));
+
+        const float next = pos.x + dir * Node::m_rest_length;
+        if (next < m_min.x || next > m_max.x)
+        {
+            pos.y += Node::m_rest_length;
+            dir    = -dir;
+        }
+        else
+            pos.x = next;
     }
 }
 
-void Rope::simulate()
+void Rope::simulate(float timestep, const glm::vec2& pin)
 {
-    const glm::vec2 mouse_pos = ImGui::GetMousePos();
+    PROFILE_SCOPE("simulate");
+
+    m_stats  = {};
+    m_time  += timestep;
 
     spawn_circles();
 
-    // update & draw all the circles
-    for (u32 i = 0; i < m_circles.size(); ++i)
+    // update all the circles
     {
-        auto& circle = m_circles[i];
+        PROFILE_SCOPE("update_circles");
+        Perf_Scope  perf(PERF_STAGE_CIRCLES, m_circles.size());
+        Stage_Timer timer(m_stats, SIM_STAGE_CIRCLES);
 
-        if (circle.finished_path())
+        for (u32 i = 0; i < m_circles.size(); ++i)
         {
-            m_circles.erase(m_circles.begin() + i);
-            continue;
-        }
+            auto& circle = m_circles[i];
+
+            if (circle.finished_path())
+            {
+                m_circles.erase(m_circles.begin() + i);
+                continue;
+            }
 
-        circle.update();
+            circle.update(timestep);
+        }
     }
 
-    for (u32 i = 0u; i < m_nodes.size() - 1u; ++i)
+    m_stats.m_nodes   = (u32)m_nodes.size();
+    m_stats.m_circles = (u32)m_circles.size();
+
+    const u32 substeps = std::max(m_settings.substeps, 1u);
+    for (u32 substep = 0u; substep < substeps; ++substep)
+        step_nodes(timestep / substeps, pin);
+}
+
+// one pass down the rope, each node is pinned, collided, integrated and constrained against the next one before moving
+// on, so the next node already feels this one's correction. the last node is only ever moved by its constraint
+void Rope::step_nodes(float timestep, const glm::vec2& pin)
+{
+    PROFILE_SCOPE("nodes");
+    Stage_Timer timer(m_stats, SIM_STAGE_NODES);
+
+    const u32  last = (u32)m_nodes.size() - 1u;
+    Perf_Scope perf(PERF_STAGE_NODES, last);
+
+    const bool pinned     = !glm::any(glm::equal(glm::vec2(-FLT_MAX, -FLT_MAX), pin));
+    const u32  iterations = std::max(m_settings.iterations, 1u);
+
+    float residual = 0.0f;
+    for (u32 i = 0u; i < last; ++i)
     {
         auto& node      = m_nodes[i];
         auto& next_node = m_nodes[i + 1u];
 
-        if (node.m_static && !glm::any(glm::equal(glm::vec2(-FLT_MAX, -FLT_MAX), mouse_pos)))
-            node.m_pos = mouse_pos;
+        // the static node follows the mouse
+        if (node.m_static && pinned)
+            node.m_pos = pin;
 
         // collide all the circles against the nodes of our rope
         for (auto& circle : m_circles)
-            node.collide(circle);
+            m_stats.m_contacts += node.collide(circle);
 
         // perform verlet integration, apply gravity, etc
-        node.simulate();
+        node.simulate(timestep);
+
+        // relax the segment towards its rest length
+        float error = 0.0f;
+        for (u32 iter = 1u; iter <= iterations; ++iter)
+        {
+            error = node.constrain(next_node, m_min, m_max);
+            ++m_stats.m_iterations;
+
+            if (error <= m_settings.tolerance)
+                break;
+        }
+
+        residual = std::max(residual, error);
+    }
+
+    m_stats.m_candidate_pairs += last * (u32)m_circles.size();
+    m_stats.m_residual         = residual;
+}
+
+std::vector<Rope> make_ropes(const glm::vec2& min, const glm::vec2& max, const Rope_Settings& settings, u32 count, u32 nodes)
+{
+    std::vector<Rope> ropes{};
+    ropes.reserve(count);
+
+    // laid out in the same spot with the same circles every rope would do identical work, which only looks like scaling
+    const float band = (max.y - min.y) / (float)std::max(count, 1u);
+    for (u32 i = 0u; i < count; ++i)
+    {
+        Rope& rope = ropes.emplace_back(glm::vec2(min.x, min.y + band * i), glm::vec2(max.x, min.y + band * (i + 1u)), settings, nodes);
+        rope.m_min             = min;
+        rope.m_max             = max;
+        rope.m_spawned_circles = (u64)i << 32;
+    }
 
-        for (u32 iter = 1u; iter <= 16u; ++iter)
-            node.constrain(next_node);
+    return ropes;
+}
+
+Rope_Stats simulate_ropes(std::span<Rope> ropes, float timestep, const glm::vec2& pin, const glm::vec2& spacing, u32 threads)
+{
+    PROFILE_SCOPE("simulate_ropes");
+
+    const auto begin  = std::chrono::steady_clock::now();
+    const bool pinned = !glm::any(glm::equal(glm::vec2(-FLT_MAX, -FLT_MAX), pin));
+
+    // ropes never touch each other, so they're the unit of work. a rope's own loop is sequential
+    g_thread_pool.parallel_for((u32)ropes.size(), threads, 1u, [&](u32 first, u32 last)
+    {
+        for (u32 i = first; i < last; ++i)
+            ropes[i].simulate(timestep, pinned ? pin + spacing * (float)i : pin);
+    });
 
-        g_render->get_dl("game")->PathLineTo(node.m_pos);
+    Rope_Stats total{};
+    for (const auto& rope : ropes)
+    {
+        const Rope_Stats& stats = rope.m_stats;
+
+        for (u32 stage = 0u; stage < SIM_STAGE_MAX; ++stage)
+            total.m_stage_ms[stage] += stats.m_stage_ms[stage];
+
+        total.m_nodes           += stats.m_nodes;
+        total.m_circles         += stats.m_circles;
+        total.m_candidate_pairs += stats.m_candidate_pairs;
+        total.m_contacts        += stats.m_contacts;
+        total.m_iterations      += stats.m_iterations;
+        total.m_residual         = std::max(total.m_residual, stats.m_residual);
     }
+
+    total.m_wall_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    return total;
 }
 
 void Rope::draw()
 {
-    g_render->get_dl("game")->PathStroke(IM_COL32_WHITE, 0, 4.0f);
+    PROFILE_SCOPE("rope_draw");
+
+    // the batches are filled later in the frame, see Render::build_layers
+    g_render->m_circle_renderer.add_circles(m_circles);
+    g_render->m_rope_renderer.add_rope(m_nodes, IM_COL32_WHITE, 4.0f);
 }
 
 void Rope::spawn_circles()
 {
-    static double time_since_spawn = ImGui::GetTime();
+    PROFILE_SCOPE("spawn_circles");
+    Perf_Scope perf(PERF_STAGE_SPAWN, 1u);
 
     // do we have too many circles already?
-    if (m_circles.size() >= 32u)
+    if (m_circles.size() >= m_settings.max_circles)
         return;
 
     // if there's no circles alive or it's been long enough since the last one was spawned, spawn one
-    if (m_circles.empty() || ImGui::GetTime() - time_since_spawn > 0.25)
+    if (m_circles.empty() || m_time - m_last_spawn > m_settings.spawn_interval)
     {
-        m_circles.push_back(Circle());
-        time_since_spawn = ImGui::GetTime();
+        m_circles.push_back(Circle(m_spawned_circles++, m_min, m_max));
+        m_last_spawn = m_time;
     }
 }
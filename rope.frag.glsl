@@ -0,0 +1,20 @@
+#version 330 core
+
+in vec2  local;
+in vec2  segment;
+in float half_width;
+in vec4  color;
+
+out vec4 out_col;
+
+void main()
+{
+    // distance to the segment, this gives us a capsule with round caps
+    float h    = clamp(dot(local, segment) / max(dot(segment, segment), 1e-6), 0.0, 1.0);
+    float dist = length(local - segment * h);
+
+    // one pixel wide anti-aliased edge
+    float coverage = clamp(half_width - dist + 0.5, 0.0, 1.0);
+
+    out_col = vec4(color.rgb, color.a * coverage);
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <memory>
+#include <span>
+#include <string_view>
 
 #include <glm/glm.hpp>
 #include <imgui.h>
@@ -21,9 +24,14 @@ class Node
 public:
     Node() = default;
     Node(bool is_static, const glm::vec2& pos);
-    void simulate();
-    void constrain(Node& next_node);
-    void collide(const Circle& circle);
+    void simulate(float timestep);
+
+    // returns how far the segment was off its rest length before being corrected, relative to the rest length. both nodes
+    // are kept inside min/max
+    float constrain(Node& next_node, const glm::vec2& min, const glm::vec2& max);
+
+    // returns whether we were inside the circle
+    bool collide(const Circle& circle);
 
     glm::vec2 m_pos;
     glm::vec2 m_last_pos;
@@ -32,15 +40,84 @@ class Node
     static constexpr float m_rest_length = 10.f;
 };
 
+// knobs the performance overlay tunes live
+struct Rope_Settings
+{
+    u32   iterations = 16u;  // constraint iterations per segment and substep, an upper bound when tolerance is set
+    u32   substeps   = 1u;   // the frame's timestep is split over this many passes down the rope
+    float tolerance  = 0.0f; // stop iterating a segment once it's off its rest length by no more than this fraction, 0 never stops early
+    u32   threads    = 1u;   // ropes are simulated and the draw batches filled on up to this many threads of g_thread_pool
+
+    // size of the scene, the demo rebuilds its ropes when these change
+    u32 ropes = 1u;
+    u32 nodes = 30u; // per rope
+
+    // circles alive at once and the seconds between spawns, storage for max_circles is reserved up front
+    u32   max_circles    = 32u;
+    float spawn_interval = 0.25f;
+};
+
+// each node is collided, integrated and constrained before the next one, so those are timed together as one stage
+enum Sim_Stage : u8
+{
+    SIM_STAGE_CIRCLES = 0,
+    SIM_STAGE_NODES,
+
+    SIM_STAGE_MAX,
+};
+
+constexpr std::array<std::string_view, SIM_STAGE_MAX> sim_stage_names = {
+    "circles",
+    "nodes",
+};
+
+// what the last simulate() did
+struct Rope_Stats
+{
+    std::array<float, SIM_STAGE_MAX> m_stage_ms; // cpu time, summed over substeps
+    u32                              m_nodes;
+    u32                              m_circles;
+    u32                              m_candidate_pairs; // node/circle pairs tested
+    u32                              m_contacts;        // pairs that were actually touching
+    u32                              m_iterations;      // constraint iterations run, summed over segments and substeps
+    float                            m_residual;        // worst relative stretch a segment's final iteration found
+    float                            m_wall_ms;         // simulate_ropes only, the whole step however many threads it took
+};
+
 class Rope
 {
     void spawn_circles();
+    void step_nodes(float timestep, const glm::vec2& pin);
 
 public:
-    Rope();
-    void simulate();
+    // the rope and its circles stay inside min/max, nothing here needs a window or ImGui so it can run on its own
+    Rope(const glm::vec2& min, const glm::vec2& max, const Rope_Settings& settings = {}, u32 nodes = 30u);
+
+    // advances everything by timestep, the static node is moved to pin unless it's -FLT_MAX (e.g. the mouse is outside)
+    void simulate(float timestep, const glm::vec2& pin);
     void draw();
 
+    Rope_Settings m_settings;
+    Rope_Stats    m_stats;
+    glm::vec2     m_min;
+    glm::vec2     m_max;
+
     std::vector<Node>   m_nodes;
     std::vector<Circle> m_circles;
+
+    // ids handed out to circles, used as their rng stream. make_ropes starts each rope at its own base so no two spawn
+    // the same circles
+    u64 m_spawned_circles;
+
+    // simulated seconds, circles spawn on this clock so runs with a fixed timestep are reproducible
+    double m_time;
+    double m_last_spawn;
 };
+
+// count ropes of nodes each, rope i is laid out in the i-th horizontal band of min/max and hands out circle ids from
+// i << 32 up. every rope then moves within the whole of min/max
+std::vector<Rope> make_ropes(const glm::vec2& min, const glm::vec2& max, const Rope_Settings& settings, u32 count, u32 nodes);
+
+// steps every rope, each one start to finish on one of up to threads threads of g_thread_pool. rope i's static node is
+// moved to pin + spacing * i, none are if pin is -FLT_MAX. returns the stats of every rope added up
+Rope_Stats simulate_ropes(std::span<Rope> ropes, float timestep, const glm::vec2& pin, const glm::vec2& spacing, u32 threads);
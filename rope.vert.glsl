@@ -0,0 +1,41 @@
+#version 330 core
+
+uniform mat4 u_projection;
+
+// each instance is one segment, start and end are consecutive vertices in the same buffer
+layout(location = 0) in vec3 in_start; // xy = position, z = width
+layout(location = 1) in vec4 in_color;
+layout(location = 2) in vec3 in_end;
+
+out vec2  local;      // fragment position relative to the start of the segment
+out vec2  segment;    // end - start
+out float half_width;
+out vec4  color;
+
+void main()
+{
+    // a zero width marks a break between ropes, push the quad outside the clip volume
+    if (in_start.z <= 0.0 || in_end.z <= 0.0)
+    {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    segment    = in_end.xy - in_start.xy;
+    half_width = in_start.z * 0.5;
+    color      = in_color;
+
+    float seg_len = length(segment);
+    vec2  tangent = seg_len > 1e-6 ? segment / seg_len : vec2(1.0, 0.0);
+    vec2  normal  = vec2(-tangent.y, tangent.x);
+
+    // pad by a pixel for anti-aliasing, the quad also extends past both ends so the caps of neighbouring segments form round joins
+    float extent = half_width + 1.0;
+
+    // triangle strip corners, x picks the end of the segment and y picks the side
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+    vec2 pos    = (corner.x < 0.0 ? in_start.xy - tangent * extent : in_end.xy + tangent * extent) + normal * corner.y * extent;
+
+    local       = pos - in_start.xy;
+    gl_Position = u_projection * vec4(pos, 0.0, 1.0);
+}
@@ -0,0 +1,59 @@
+#include "render.h"
+#include "rope.h"
+#include "rope_renderer.h"
+
+Rope_Renderer::Rope_Renderer() : m_batch(), m_vertices(), m_batches(), m_queued() {}
+
+bool Rope_Renderer::init(const Shaders& shaders)
+{
+    // instance i reads vertex i as its start and vertex i + 1 as its end
+    constexpr std::array<Instance_Attribute, 3> attributes = {{
+        {0u, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, m_pos)},
+        {1u, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, m_color)},
+        {2u, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex) + offsetof(Vertex, m_pos)},
+    }};
+
+    return m_batch.init(shaders, "rope", sizeof(Vertex), attributes);
+}
+
+void Rope_Renderer::on_new_frame()
+{
+    m_vertices.clear();
+    m_batches.clear();
+    m_queued = 0u;
+}
+
+void Rope_Renderer::add_rope(std::span<const Node> nodes, ImU32 color, float width)
+{
+    if (nodes.size() < 2u)
+        return;
+
+    // separate us from the previous rope
+    if (!m_batches.empty())
+        m_vertices.push_back(Vertex{m_batches.back().m_items.back().m_pos, 0.0f, 0u});
+
+    m_batches.push_back(Batch{nodes, (u32)m_vertices.size(), color, width});
+    m_vertices.resize(m_vertices.size() + nodes.size());
+    m_queued += (u32)nodes.size();
+}
+
+void Rope_Renderer::build(u32 begin, u32 end)
+{
+    for_each_queued<Batch>(m_batches, begin, end, [&](const Batch& batch, u32 i)
+    {
+        m_vertices[batch.m_first + i] = Vertex{batch.m_items[i].m_pos, batch.m_width, batch.m_color};
+    });
+}
+
+void Rope_Renderer::draw(ImDrawList& dl)
+{
+    if (m_vertices.size() < 2u)
+        return;
+
+    m_batch.draw(dl, m_vertices.data(), (GLsizeiptr)(m_vertices.size() * sizeof(Vertex)), (GLsizei)m_vertices.size() - 1);
+}
+
+u64 Rope_Renderer::hash() const
+{
+    return hash_span<Vertex>(m_vertices);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include <glm/glm.hpp>
+#include <imgui.h>
+
+#include "shaders.h"
+#include "hash.h"
+#include "instanced_batch.h"
+
+class Node;
+
+// draws every rope in a single instanced draw call, one instance per segment
+// node positions are streamed into an orphaned vbo and the vertex shader expands each segment into an anti-aliased capsule
+class Rope_Renderer
+{
+    struct Vertex
+    {
+        glm::vec2 m_pos;
+        float     m_width; // 0 marks a break between two ropes, segments touching it aren't drawn
+        ImU32     m_color;
+    };
+    static_assert(sizeof(Vertex) == 16u, "rope.vert.glsl expects tightly packed 16 byte vertices");
+
+    // a rope queued this frame, its vertices are written by build()
+    struct Batch
+    {
+        std::span<const Node> m_items;
+        u32                   m_first; // index of its first vertex
+        ImU32                 m_color;
+        float                 m_width;
+    };
+
+    Instanced_Batch     m_batch;
+    std::vector<Vertex> m_vertices;
+    std::vector<Batch>  m_batches;
+    u32                 m_queued; // nodes across every batch
+
+public:
+    Rope_Renderer();
+
+    bool init(const Shaders& shaders);
+    void on_new_frame();
+
+    // only reserves the rope's vertices, the nodes have to stay where they are until build() has run
+    void add_rope(std::span<const Node> nodes, ImU32 color, float width);
+
+    // writes the vertices of nodes [begin, end), counted across every rope in the order they were added. ranges that
+    // don't overlap can be built on different threads
+    void build(u32 begin, u32 end);
+    u32  queued() const { return m_queued; }
+
+    // queue the batch onto a draw list, call once per frame after every rope has been added and built
+    void draw(ImDrawList& dl);
+
+    // hash of everything built this frame, lets the layer tell whether it has to be re-rendered
+    u64 hash() const;
+};
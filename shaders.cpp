@@ -1,8 +1,87 @@
 #include <print>
+#include <format>
 #include <fstream>
 #include <map>
+#include <algorithm>
+#include <cstring>
 
 #include "shaders.h"
+#include "hash.h"
+#include "gl_state.h"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// shader sources are loaded (and watched) from here
+static const std::filesystem::path shader_folder = "./";
+
+// compiled programs are kept here between launches
+static const std::filesystem::path shader_cache_folder = "./shader_cache/";
+
+struct Program_Binary_Header
+{
+    static constexpr u32 current_magic = 0x52505342u; // 'RPSB', bump when the layout changes
+
+    u32    m_magic;
+    GLenum m_format;
+    u64    m_source_hash;
+    u64    m_driver_hash;
+    u32    m_length;
+};
+
+// a binary is only valid for the exact driver that produced it
+static u64 get_driver_hash()
+{
+    static const u64 hash = []
+    {
+        u64 ret = fnv1a_basis;
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            const char* str = (const char*)glGetString(name);
+            if (str)
+                ret = hash_bytes(str, std::strlen(str), ret);
+        }
+
+        return ret;
+    }();
+
+    return hash;
+}
+
+static std::string load_file(const std::filesystem::path& p)
+{
+    std::ifstream file(p, std::ios::in);
+
+    std::error_code ec{};
+    const size_t    filesize = std::filesystem::file_size(p, ec);
+
+    if (ec)
+        return {};
+
+    std::string ret(filesize, '\0');
+    file.read(ret.data(), filesize);
+
+    return ret;
+}
+
+static u64 hash_sources(const std::string& vert_src, const std::string& frag_src)
+{
+    return hash_bytes(frag_src.data(), frag_src.size(), hash_bytes(vert_src.data(), vert_src.size()));
+}
+
+static bool program_binaries_supported()
+{
+    // core in 4.1, before that it's only there if the driver exposes ARB_get_program_binary
+    if (glGetProgramBinary == nullptr || glProgramBinary == nullptr)
+        return false;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+    return formats > 0;
+}
 
 bool Shader::validate_shader()
 {
@@ -38,7 +117,7 @@ bool Shader::validate_program()
     glGetProgramiv(m_shader_program, GL_INFO_LOG_LENGTH, &log_length);
 
     if ((GLboolean)status == GL_FALSE)
-        std::print("failed to link program for {}\n", std::quoted(m_name)._Str);
+        std::print("failed to link program for \"{}\"\n", m_name);
 
     if (log_length > 1)
     {
@@ -58,56 +137,334 @@ bool Shader::validate()
     return validate_shader() && validate_program();
 }
 
-Shader Shaders::get_shader(size_t hash)
+void Shader::reflect_uniforms()
 {
-    Shader ret{};
-    for (auto& shader : m_shaders)
+    m_uniforms.fill(-1);
+
+    GLint count = 0, max_length = 0;
+    glGetProgramiv(m_shader_program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_shader_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::string name((size_t)max_length, '\0');
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(m_shader_program, (GLuint)i, max_length, &length, &size, &type, name.data());
+
+        // arrays are reported as "u_name[0]", their location is the location of the first element
+        std::string_view active_name(name.data(), (size_t)length);
+        active_name = active_name.substr(0, active_name.find('['));
+
+        const auto it = std::find(uniform_names.begin(), uniform_names.end(), active_name);
+        if (it == uniform_names.end())
+        {
+            std::print("\"{}\" has an unknown uniform \"{}\"\n", m_name, active_name);
+            continue;
+        }
+
+        m_uniforms[it - uniform_names.begin()] = glGetUniformLocation(m_shader_program, std::string(active_name).c_str());
+    }
+}
+
+std::filesystem::path Shader::get_binary_path() const
+{
+    if (m_defines.empty())
+        return shader_cache_folder / (m_name + ".bin");
+
+    return shader_cache_folder / std::format("{}.{:016x}.bin", m_name, hash_bytes(m_defines.data(), m_defines.size()));
+}
+
+std::string Shader::with_defines(const std::string& src) const
+{
+    if (m_defines.empty())
+        return src;
+
+    // #version has to stay the first line, #line keeps compile errors pointing at the right line of the file
+    const size_t version = src.find("#version");
+    const size_t end     = version == std::string::npos ? std::string::npos : src.find('\n', version);
+
+    if (end == std::string::npos)
+        return m_defines + src;
+
+    return src.substr(0u, end + 1u) + m_defines + "#line 2\n" + src.substr(end + 1u);
+}
+
+bool Shader::load_binary()
+{
+    if (!program_binaries_supported())
+        return false;
+
+    std::ifstream file(get_binary_path(), std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+
+    Program_Binary_Header header{};
+    file.read((char*)&header, sizeof(header));
+
+    // the sources or the driver changed since this was saved, fall back to compiling
+    if (!file || header.m_magic != Program_Binary_Header::current_magic || header.m_source_hash != m_source_hash
+        || header.m_driver_hash != get_driver_hash())
+        return false;
+
+    std::string binary(header.m_length, '\0');
+    if (!file.read(binary.data(), header.m_length))
+        return false;
+
+    m_vert_shader    = 0u;
+    m_frag_shader    = 0u;
+    m_shader_program = glCreateProgram();
+    glProgramBinary(m_shader_program, header.m_format, binary.data(), (GLsizei)header.m_length);
+
+    // drivers are allowed to reject a binary for any reason
+    GLint status = 0;
+    glGetProgramiv(m_shader_program, GL_LINK_STATUS, &status);
+
+    if ((GLboolean)status == GL_FALSE)
     {
-        if (hash == shader.m_hash)
-            ret = shader;
+        glDeleteProgram(m_shader_program);
+        m_shader_program = 0u;
+        return false;
     }
 
+    return true;
+}
+
+void Shader::save_binary()
+{
+    if (!program_binaries_supported())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(m_shader_program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0)
+        return;
+
+    Program_Binary_Header header{};
+    header.m_magic       = Program_Binary_Header::current_magic;
+    header.m_source_hash = m_source_hash;
+    header.m_driver_hash = get_driver_hash();
+
+    std::string binary((size_t)length, '\0');
+    glGetProgramBinary(m_shader_program, length, &length, &header.m_format, binary.data());
+    header.m_length = (u32)length;
+
+    std::error_code ec{};
+    std::filesystem::create_directories(shader_cache_folder, ec);
+
+    std::ofstream file(get_binary_path(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+        return;
+
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), length);
+}
+
+Shader::Pending Shader::compile(const std::string& vert_src, const std::string& frag_src) const
+{
+    Pending ret{};
+    ret.m_source_hash = hash_sources(vert_src, frag_src);
+
+    const char* vert_src_ptr = vert_src.data();
+    const char* frag_src_ptr = frag_src.data();
+
+    ret.m_vert_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(ret.m_vert_shader, 1, &vert_src_ptr, nullptr);
+    glCompileShader(ret.m_vert_shader);
+
+    ret.m_frag_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(ret.m_frag_shader, 1, &frag_src_ptr, nullptr);
+    glCompileShader(ret.m_frag_shader);
+
+    ret.m_shader_program = glCreateProgram();
+    glAttachShader(ret.m_shader_program, ret.m_vert_shader);
+    glAttachShader(ret.m_shader_program, ret.m_frag_shader);
+
+    if (program_binaries_supported())
+        glProgramParameteri(ret.m_shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    glLinkProgram(ret.m_shader_program);
+
     return ret;
 }
 
-void Shaders::activate_shader(const Shader& shader)
+bool Shader::build(const std::string& vert_src, const std::string& frag_src)
 {
-    glUseProgram(shader.m_shader_program);
+    m_source_hash = hash_sources(vert_src, frag_src);
+
+    if (load_binary())
+    {
+        reflect_uniforms();
+        return true;
+    }
+
+    const Pending program = compile(vert_src, frag_src);
+    m_vert_shader         = program.m_vert_shader;
+    m_frag_shader         = program.m_frag_shader;
+    m_shader_program      = program.m_shader_program;
+
+    if (!validate())
+        return false;
+
+    save_binary();
+    reflect_uniforms();
+
+    return true;
 }
 
-Shader Shaders::get_shader(std::string_view name)
+void Shader::begin_reload()
 {
-    return get_shader(std::hash<std::string_view>{}(name));
+    const std::string vert_src = with_defines(load_file(m_vert_path));
+    const std::string frag_src = with_defines(load_file(m_frag_path));
+
+    // editors can leave a file empty for a moment while saving, we'll get another event once they're done
+    if (vert_src.empty() || frag_src.empty())
+        return;
+
+    // a newer edit replaces a reload that's still compiling
+    if (m_pending)
+    {
+        glDeleteShader(m_pending->m_vert_shader);
+        glDeleteShader(m_pending->m_frag_shader);
+        glDeleteProgram(m_pending->m_shader_program);
+        m_pending.reset();
+    }
+
+    // saved without changes
+    if (hash_sources(vert_src, frag_src) == m_source_hash)
+        return;
+
+    m_pending = compile(vert_src, frag_src);
 }
 
-void Shaders::activate_shader(std::string_view name)
+bool Shader::poll_reload(bool parallel_compile)
 {
-    activate_shader(get_shader(name));
+    if (!m_pending)
+        return false;
+
+    // without parallel compile the status queries below may block, but only on the frame after the edit
+    if (parallel_compile)
+    {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(m_pending->m_shader_program, GL_COMPLETION_STATUS_KHR, &completed);
+
+        if (completed == GL_FALSE)
+            return false;
+    }
+
+    const Pending pending = *m_pending;
+    m_pending.reset();
+
+    // check the new program the same way we check a fresh one, the old program stays active if it's broken
+    Shader next           = *this;
+    next.m_vert_shader    = pending.m_vert_shader;
+    next.m_frag_shader    = pending.m_frag_shader;
+    next.m_shader_program = pending.m_shader_program;
+    next.m_source_hash    = pending.m_source_hash;
+
+    if (!next.validate())
+    {
+        std::print("keeping the previous \"{}\" program\n", m_name);
+
+        glDeleteShader(pending.m_vert_shader);
+        glDeleteShader(pending.m_frag_shader);
+        glDeleteProgram(pending.m_shader_program);
+        return false;
+    }
+
+    // the driver holds on to the old program until the gpu is done with it
+    glDeleteShader(m_vert_shader);
+    glDeleteShader(m_frag_shader);
+    glDeleteProgram(m_shader_program);
+
+    *this = std::move(next);
+
+    save_binary();
+    reflect_uniforms();
+
+    std::print("reloaded \"{}\"\n", m_name);
+    return true;
 }
 
-bool Shaders::load_shaders()
+Shaders::Shaders() : m_shaders(), m_watch_fd(-1), m_last_poll(), m_watching(), m_parallel_compile(), m_generation() {}
+
+Shader_Handle Shaders::find(std::string_view name) const
 {
-    auto load_file = [](const std::filesystem::path& p)
+    const size_t hash = std::hash<std::string_view>{}(name);
+
+    for (u32 i = 0u; i < m_shaders.size(); ++i)
     {
-        std::ifstream file(p, std::ios::in);
+        if (hash == m_shaders[i].m_hash && m_shaders[i].m_defines.empty())
+            return Shader_Handle{i};
+    }
 
-        const size_t filesize = std::filesystem::file_size(p);
+    std::print("failed to find the \"{}\" shader\n", name);
+    return Shader_Handle{};
+}
 
-        std::string ret(filesize, '\0');
-        file.read(ret.data(), filesize);
+Shader_Handle Shaders::get_variant(std::string_view name, std::span<const Shader_Define> defines)
+{
+    const Shader_Handle base = find(name);
+    if (!base.valid() || defines.empty())
+        return base;
 
-        return ret;
-    };
+    std::string block{};
+    for (auto& define : defines)
+        block += std::format("#define {} {}\n", define.m_name, define.m_value);
 
-    const auto parent_folder = std::filesystem::path("./");
+    for (u32 i = 0u; i < m_shaders.size(); ++i)
+    {
+        if (m_shaders[i].m_hash == m_shaders[base.m_index].m_hash && m_shaders[i].m_defines == block)
+            return Shader_Handle{i};
+    }
+
+    // same sources and name as the base program, only the defines differ
+    Shader variant{};
+    variant.m_name       = m_shaders[base.m_index].m_name;
+    variant.m_hash       = m_shaders[base.m_index].m_hash;
+    variant.m_vert_path  = m_shaders[base.m_index].m_vert_path;
+    variant.m_frag_path  = m_shaders[base.m_index].m_frag_path;
+    variant.m_last_write = m_shaders[base.m_index].m_last_write;
+    variant.m_defines    = std::move(block);
+
+    if (!variant.build(variant.with_defines(load_file(variant.m_vert_path)), variant.with_defines(load_file(variant.m_frag_path))))
+    {
+        std::print("failed to build a variant of \"{}\"\n", name);
+        return Shader_Handle{};
+    }
 
+    m_shaders.push_back(std::move(variant));
+    return Shader_Handle{(u32)m_shaders.size() - 1u};
+}
+
+const Shader& Shaders::get(Shader_Handle handle) const
+{
+    // an invalid handle gets an empty shader, program 0 draws nothing
+    static const Shader empty = []
+    {
+        Shader shader{};
+        shader.m_uniforms.fill(-1);
+        return shader;
+    }();
+    return handle.valid() ? m_shaders[handle.m_index] : empty;
+}
+
+void Shaders::activate_shader(Shader_Handle handle) const
+{
+    glUseProgram(get(handle).m_shader_program);
+}
+
+bool Shaders::load_shaders()
+{
     // the path doesn't exist
-    if (parent_folder.empty())
+    if (!std::filesystem::exists(shader_folder))
         return false;
 
     // shader_name(e.g. 'fog') : vert_path, frag_path
     std::map<std::string, std::pair<std::filesystem::path, std::filesystem::path>> shader_paths;
-    for (auto& it : std::filesystem::directory_iterator(parent_folder))
+    for (auto& it : std::filesystem::directory_iterator(shader_folder))
     {
         auto& path = it.path();
 
@@ -130,7 +487,7 @@ bool Shaders::load_shaders()
     if (shader_paths.empty())
         return false;
 
-    // load all the shaders, compile them, put them into m_shaders
+    // load all the shaders, compile them (or pull them from the binary cache), put them into m_shaders
     for (auto& [key, value] : shader_paths)
     {
         const auto& [vert_path, frag_path] = value;
@@ -147,27 +504,118 @@ bool Shaders::load_shaders()
         const std::string vert_src = load_file(vert_path);
         const std::string frag_src = load_file(frag_path);
 
-        const char* vert_src_ptr = vert_src.data();
-        const char* frag_src_ptr = frag_src.data();
+        if (!shader.build(vert_src, frag_src))
+            return false;
 
-        shader.m_vert_shader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(shader.m_vert_shader, 1, &vert_src_ptr, nullptr);
-        glCompileShader(shader.m_vert_shader);
+        shader.m_last_write = std::max(std::filesystem::last_write_time(vert_path), std::filesystem::last_write_time(frag_path));
 
-        shader.m_frag_shader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(shader.m_frag_shader, 1, &frag_src_ptr, nullptr);
-        glCompileShader(shader.m_frag_shader);
+        m_shaders.push_back(shader);
+    }
 
-        shader.m_shader_program = glCreateProgram();
-        glAttachShader(shader.m_shader_program, shader.m_vert_shader);
-        glAttachShader(shader.m_shader_program, shader.m_frag_shader);
-        glLinkProgram(shader.m_shader_program);
+    return true;
+}
 
-        if (!shader.validate())
-            return false;
+void Shaders::enable_hot_reload(Max_Shader_Compiler_Threads_Fn max_compiler_threads)
+{
+    // let the driver pick how many threads to compile with
+    m_parallel_compile = max_compiler_threads != nullptr;
+    if (m_parallel_compile)
+        max_compiler_threads(0xFFFFFFFFu);
 
-        m_shaders.push_back(shader);
+#if defined(__linux__)
+    m_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_watch_fd >= 0 && inotify_add_watch(m_watch_fd, shader_folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        close(m_watch_fd);
+        m_watch_fd = -1;
     }
+#endif
 
-    return true;
+    m_watching = true;
+}
+
+void Shaders::on_file_changed(const std::filesystem::path& path)
+{
+    if (path.extension() != ".glsl")
+        return;
+
+    // e.g. fog.vert.glsl -> fog
+    const std::string filename    = path.filename().string();
+    const std::string shader_name = filename.substr(0, filename.find_first_of('.'));
+    const size_t      hash        = std::hash<std::string>{}(shader_name);
+
+    for (auto& shader : m_shaders)
+    {
+        if (shader.m_hash == hash)
+            shader.begin_reload();
+    }
+}
+
+void Shaders::check_write_times()
+{
+    for (auto& shader : m_shaders)
+    {
+        // either file can be missing mid-save, a failed query would read as the oldest possible time
+        std::error_code vert_ec{}, frag_ec{};
+        const auto      vert_write = std::filesystem::last_write_time(shader.m_vert_path, vert_ec);
+        const auto      frag_write = std::filesystem::last_write_time(shader.m_frag_path, frag_ec);
+        if (vert_ec || frag_ec)
+            continue;
+
+        const auto last_write = std::max(vert_write, frag_write);
+        if (last_write <= shader.m_last_write)
+            continue;
+
+        shader.m_last_write = last_write;
+        shader.begin_reload();
+    }
+}
+
+void Shaders::poll_reloads()
+{
+    if (!m_watching)
+        return;
+
+    // swap in anything that finished compiling since last frame, before picking up new edits
+    for (auto& shader : m_shaders)
+    {
+        if (shader.poll_reload(m_parallel_compile))
+        {
+            // the old program is gone and its name can be reused, don't let the cache skip binding the new one
+            g_gl_state.invalidate();
+            ++m_generation;
+        }
+    }
+
+#if defined(__linux__)
+    if (m_watch_fd >= 0)
+    {
+        alignas(inotify_event) char buffer[4096];
+
+        ssize_t length = 0;
+        while ((length = read(m_watch_fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* it = buffer; it < buffer + length;)
+            {
+                const auto event = (const inotify_event*)it;
+
+                if (event->len > 0u)
+                    on_file_changed(event->name);
+
+                it += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        return;
+    }
+#endif
+
+    // no inotify, compare write times twice a second instead
+    const auto now = std::chrono::steady_clock::now();
+    if (now - m_last_poll < std::chrono::milliseconds(500))
+        return;
+
+    m_last_poll = now;
+    check_write_times();
 }
@@ -1,25 +1,100 @@
 #pragma once
 
 #include <vector>
+#include <array>
+#include <string>
+#include <string_view>
+#include <span>
 #include <filesystem>
+#include <optional>
+#include <chrono>
 
 #include <imgui.h>
 #include <glad/glad.h>
 
 #include "types.h"
 
+// every uniform used by our shaders, locations are reflected once at link time so nothing is looked up by name per frame
+enum Uniform : u8
+{
+    UNIFORM_PROJECTION = 0,
+    UNIFORM_TEX,
+
+    UNIFORM_MAX,
+};
+
+constexpr std::array<std::string_view, UNIFORM_MAX> uniform_names = {
+    "u_projection",
+    "u_tex",
+};
+
+// injected right after #version, each set of defines is compiled into its own program
+struct Shader_Define
+{
+    std::string_view m_name;
+    std::string      m_value;
+};
+
+// KHR_parallel_shader_compile (and the identical ARB version) isn't part of our glad build
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+using Max_Shader_Compiler_Threads_Fn = void(APIENTRYP)(GLuint count);
+
+// index into Shaders, resolve it once with Shaders::find and keep it around
+struct Shader_Handle
+{
+    u32 m_index = ~0u;
+
+    bool valid() const
+    {
+        return m_index != ~0u;
+    }
+};
+
 class Shader
 {
     friend class Shaders;
 
 private:
+    // a program that's been compiled and linked but not checked yet
+    struct Pending
+    {
+        GLuint m_vert_shader;
+        GLuint m_frag_shader;
+        GLuint m_shader_program;
+        u64    m_source_hash;
+    };
+
     bool validate_shader();
     bool validate_program();
+    void reflect_uniforms();
+
+    // program binary cache, keyed by the hash of our sources and the driver
+    std::filesystem::path get_binary_path() const;
+    bool                  load_binary();
+    void                  save_binary();
+
+    // inserts m_defines after the #version line
+    std::string with_defines(const std::string& src) const;
+
+    // issues the compile and link without waiting on either
+    Pending compile(const std::string& vert_src, const std::string& frag_src) const;
+
+    // hot reload, the new program compiles in the background while the old one stays in use
+    void begin_reload();
+    bool poll_reload(bool parallel_compile);
 
 protected:
-    std::filesystem::path m_vert_path;
-    std::filesystem::path m_frag_path;
-    size_t                m_hash;
+    std::filesystem::path           m_vert_path;
+    std::filesystem::path           m_frag_path;
+    size_t                          m_hash;
+    u64                             m_source_hash;
+    std::optional<Pending>          m_pending;    // program being rebuilt by a hot reload, swapped in once it has linked
+    std::filesystem::file_time_type m_last_write; // newest write time of our sources, only checked when inotify isn't available
+    std::string                     m_defines;    // "#define NAME VALUE" lines, empty for the unspecialized program
+
+    // -1 for uniforms the program doesn't use, glUniform* silently ignores those
+    std::array<GLint, UNIFORM_MAX> m_uniforms;
 
 public:
     GLuint      m_vert_shader;
@@ -28,19 +103,50 @@ class Shader
     std::string m_name;
 
     bool validate();
+
+    // compile and link, unless the binary cache already has a program built from the same sources
+    bool build(const std::string& vert_src, const std::string& frag_src);
+
+    GLint location(Uniform uniform) const
+    {
+        return m_uniforms[uniform];
+    }
 };
 
 class Shaders
 {
     std::vector<Shader> m_shaders;
 
-    Shader get_shader(size_t hash);
+    // hot reload
+    i32                                   m_watch_fd;         // inotify on linux, -1 elsewhere
+    std::chrono::steady_clock::time_point m_last_poll;        // without inotify we compare write times every so often
+    bool                                  m_watching;
+    bool                                  m_parallel_compile; // the driver compiles in the background and we can ask when it's done
+    u32                                   m_generation;       // bumped every time a program is swapped
+
+    void check_write_times();
+    void on_file_changed(const std::filesystem::path& path);
 
 public:
-    Shaders() = default;
+    Shaders();
+
+    bool          load_shaders();
+    Shader_Handle find(std::string_view name) const;
+
+    // specialized program, compiled the first time a set of defines is asked for and reused after that
+    Shader_Handle get_variant(std::string_view name, std::span<const Shader_Define> defines);
+
+    const Shader& get(Shader_Handle handle) const;
+    void          activate_shader(Shader_Handle handle) const;
+
+    // null if the driver doesn't support KHR/ARB_parallel_shader_compile
+    void enable_hot_reload(Max_Shader_Compiler_Threads_Fn max_compiler_threads);
+
+    // call once per frame, swaps in any program that finished rebuilding
+    void poll_reloads();
 
-    bool   load_shaders();
-    Shader get_shader(std::string_view name);
-    void   activate_shader(const Shader& shader);
-    void   activate_shader(std::string_view name);
+    u32 generation() const
+    {
+        return m_generation;
+    }
 };
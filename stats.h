@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <format>
+#include <cmath>
+#include <algorithm>
+
+#include "types.h"
+
+// the most recent samples of a measurement, older ones are overwritten so memory stays fixed however long we run
+class Rolling_Stats
+{
+    std::vector<float>         m_samples;
+    mutable std::vector<float> m_scratch; // sorted copy for percentile()
+    u32                        m_next;
+    u32                        m_count;
+    double                     m_total; // running sum so mean() doesn't have to walk the samples
+
+public:
+    Rolling_Stats(u32 capacity = 256u) : m_samples(capacity), m_scratch(), m_next(), m_count(), m_total() { m_scratch.reserve(capacity); }
+
+    void push(float sample)
+    {
+        if (m_count == m_samples.size())
+            m_total -= m_samples[m_next];
+
+        m_total          += sample;
+        m_samples[m_next] = sample;
+        m_next            = (m_next + 1u) % (u32)m_samples.size();
+        m_count           = std::min(m_count + 1u, (u32)m_samples.size());
+    }
+
+    u32  count() const { return m_count; }
+    bool empty() const { return m_count == 0u; }
+
+    float latest() const
+    {
+        return empty() ? 0.0f : m_samples[(m_next + m_samples.size() - 1u) % m_samples.size()];
+    }
+
+    float mean() const { return empty() ? 0.0f : (float)(m_total / m_count); }
+
+    float min() const { return empty() ? 0.0f : *std::min_element(m_samples.begin(), m_samples.begin() + m_count); }
+    float max() const { return empty() ? 0.0f : *std::max_element(m_samples.begin(), m_samples.begin() + m_count); }
+
+    // p in [0, 1]
+    float percentile(float p) const
+    {
+        if (empty())
+            return 0.0f;
+
+        m_scratch.assign(m_samples.begin(), m_samples.begin() + m_count);
+
+        const auto nth = m_scratch.begin() + std::min((size_t)(p * m_count), (size_t)m_count - 1u);
+        std::nth_element(m_scratch.begin(), nth, m_scratch.end());
+
+        return *nth;
+    }
+
+    // i-th oldest sample, i < count()
+    float at(u32 i) const
+    {
+        const u32 first = m_count == m_samples.size() ? m_next : 0u;
+        return m_samples[(first + i) % m_samples.size()];
+    }
+
+    // oldest sample first
+    template <typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        const u32 first = m_count == m_samples.size() ? m_next : 0u;
+        for (u32 i = 0u; i < m_count; ++i)
+            fn(m_samples[(first + i) % m_samples.size()]);
+    }
+};
+
+// every sample ever pushed, counted into logarithmically spaced buckets so memory is fixed and the relative error of a
+// percentile is the same (about 4%) whether it's a 0.1ms or a 100ms frame. values are expected in milliseconds
+class Log_Histogram
+{
+    static constexpr float min_value          = 0.01f;
+    static constexpr u32   buckets_per_octave = 16u;
+    static constexpr u32   octaves            = 20u; // up to ~10s, anything longer lands in the last bucket
+
+    std::array<u64, octaves * buckets_per_octave> m_buckets;
+    u64                                           m_count;
+    double                                        m_total;
+    float                                         m_max;
+
+    static float bucket_upper(u32 bucket) { return min_value * std::exp2((float)(bucket + 1u) / buckets_per_octave); }
+
+public:
+    Log_Histogram() : m_buckets(), m_count(), m_total(), m_max() {}
+
+    void push(float value)
+    {
+        const float scaled = std::log2(std::max(value, min_value) / min_value) * buckets_per_octave;
+        const u32   bucket = std::min((u32)scaled, (u32)m_buckets.size() - 1u);
+
+        ++m_buckets[bucket];
+        ++m_count;
+        m_total += value;
+        m_max    = std::max(m_max, value);
+    }
+
+    u64   count() const { return m_count; }
+    float mean() const { return m_count == 0u ? 0.0f : (float)(m_total / m_count); }
+    float max() const { return m_max; }
+
+    // upper edge of the bucket the p-th sample fell in, p in [0, 1]. walks a fixed number of buckets
+    float percentile(float p) const
+    {
+        const u64 target = std::max((u64)std::ceil(p * m_count), (u64)1u);
+
+        u64 seen = 0u;
+        for (u32 bucket = 0u; bucket < m_buckets.size(); ++bucket)
+        {
+            seen += m_buckets[bucket];
+            if (seen >= target)
+                return std::min(bucket_upper(bucket), m_max);
+        }
+
+        return m_max;
+    }
+
+    // non-empty buckets as [upper edge, count] pairs
+    std::string buckets_json() const
+    {
+        std::string json = "[";
+        for (u32 bucket = 0u; bucket < m_buckets.size(); ++bucket)
+        {
+            if (m_buckets[bucket] != 0u)
+                json += std::format("{}[{:.4f}, {}]", json.size() > 1u ? ", " : "", bucket_upper(bucket), m_buckets[bucket]);
+        }
+
+        return json + "]";
+    }
+};
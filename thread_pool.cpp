@@ -0,0 +1,118 @@
+#include <format>
+#include <algorithm>
+
+#include "thread_pool.h"
+#include "profiler.h"
+
+Thread_Pool::Thread_Pool() :
+    m_workers(), m_names(), m_mutex(), m_wake(), m_finished(), m_generation(), m_stop(), m_fn(), m_task(), m_count(), m_chunk(), m_participants(),
+    m_busy(), m_next()
+{}
+
+Thread_Pool::~Thread_Pool()
+{
+    shutdown();
+}
+
+void Thread_Pool::init(u32 threads)
+{
+    shutdown();
+
+    if (threads == 0u)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_stop = false;
+
+    // names first, the vector mustn't move once a worker has handed its name to the profiler
+    m_names.clear();
+    for (u32 i = 1u; i < threads; ++i)
+        m_names.push_back(std::format("worker {}", i));
+
+    for (u32 i = 1u; i < threads; ++i)
+        m_workers.emplace_back(&Thread_Pool::worker_main, this, i - 1u);
+}
+
+void Thread_Pool::shutdown()
+{
+    {
+        std::scoped_lock lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+
+    m_workers.clear();
+}
+
+void Thread_Pool::worker_main(u32 index)
+{
+#if defined(ROPE_DEMO_PROFILE)
+    g_profiler.set_thread_name(m_names[index].c_str());
+#endif
+
+    u64 seen = 0u;
+
+    while (true)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+
+            if (m_stop)
+                return;
+
+            seen = m_generation;
+
+            // not needed for this one
+            if (index >= m_participants)
+                continue;
+        }
+
+        run_chunks();
+
+        std::scoped_lock lock(m_mutex);
+        if (--m_busy == 0u)
+            m_finished.notify_one();
+    }
+}
+
+void Thread_Pool::run_chunks()
+{
+    while (true)
+    {
+        const u32 begin = m_next.fetch_add(m_chunk, std::memory_order_relaxed);
+        if (begin >= m_count)
+            return;
+
+        m_fn(m_task, begin, std::min(begin + m_chunk, m_count));
+    }
+}
+
+void Thread_Pool::dispatch(Task_Fn fn, const void* task, u32 count, u32 threads, u32 min_chunk)
+{
+    threads = std::min(threads, max_threads());
+
+    {
+        std::scoped_lock lock(m_mutex);
+
+        // a few chunks per thread so one that gets descheduled doesn't hold everyone up
+        m_fn           = fn;
+        m_task         = task;
+        m_count        = count;
+        m_chunk        = std::max((count + threads * 4u - 1u) / (threads * 4u), std::max(min_chunk, 1u));
+        m_participants = threads - 1u;
+        m_busy         = m_participants;
+        m_next.store(0u, std::memory_order_relaxed);
+        ++m_generation;
+    }
+
+    m_wake.notify_all();
+
+    run_chunks();
+
+    std::unique_lock lock(m_mutex);
+    m_finished.wait(lock, [&] { return m_busy == 0u; });
+}
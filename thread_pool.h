@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <type_traits>
+
+#include "types.h"
+
+// fork/join pool for splitting a loop across cores. every worker is started by init() so changing how many take part
+// in a loop never allocates, the ones left out just stay asleep. the calling thread always works on the loop too
+class Thread_Pool
+{
+    using Task_Fn = void (*)(const void* task, u32 begin, u32 end);
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::string> m_names; // for the profiler, which keeps the pointers
+    std::mutex               m_mutex;
+    std::condition_variable  m_wake;
+    std::condition_variable  m_finished;
+    u64                      m_generation; // bumped for every loop, workers wake up when it changes
+    bool                     m_stop;
+
+    // the loop being run, only written while no worker is on it
+    Task_Fn          m_fn;
+    const void*      m_task;
+    u32              m_count;
+    u32              m_chunk;
+    u32              m_participants; // workers taking part, the caller not included
+    u32              m_busy;         // participants that haven't finished yet
+    std::atomic<u32> m_next;         // first index of the next unclaimed chunk
+
+    void worker_main(u32 index);
+    void run_chunks();
+    void dispatch(Task_Fn fn, const void* task, u32 count, u32 threads, u32 min_chunk);
+
+public:
+    Thread_Pool();
+    ~Thread_Pool();
+
+    // starts threads - 1 workers, 0 uses every hardware thread
+    void init(u32 threads = 0u);
+    void shutdown();
+
+    // most threads a loop can use, the caller included
+    u32 max_threads() const { return (u32)m_workers.size() + 1u; }
+
+    // calls fn(begin, end) over chunks of [0, count) on up to threads threads and returns once all of them are done.
+    // chunks are at least min_chunk long so tiny loops don't pay for waking anyone up
+    template <typename Fn>
+    void parallel_for(u32 count, u32 threads, u32 min_chunk, Fn&& fn)
+    {
+        if (threads <= 1u || m_workers.empty() || count <= min_chunk)
+        {
+            fn(0u, count);
+            return;
+        }
+
+        auto trampoline = [](const void* task, u32 begin, u32 end) { (*(std::remove_reference_t<Fn>*)task)(begin, end); };
+        dispatch(trampoline, &fn, count, threads, min_chunk);
+    }
+};
+
+inline Thread_Pool g_thread_pool;